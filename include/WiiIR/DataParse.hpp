@@ -0,0 +1,353 @@
+// DataParse.hpp - (C)2025 Dakota Thorpe.
+// Allocation-free parsing of <Data> strings ("PROTO:addr,cmd", "RAW:<pronto>").
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+#ifndef WIIIR_DATA_PARSE_H
+#define WIIIR_DATA_PARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <charconv>
+#include <string_view>
+
+// Bulk hex decoding has a vector path on the host, Broadway has no integer
+// SIMD and takes the scalar one.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IR_HEX_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define IR_HEX_NEON
+#endif
+
+/*
+    DEV Notes:
+        Everything here works on string_views into the <Data> text and writes
+        into storage the caller hands in, so a parse never touches the heap.
+        Numbers go through std::from_chars, which skips the locale as well.
+        Only depends on the standard library, tools/parse_bench.cpp uses it
+        on its own.
+
+        PROTO:addr,cmd[,...]    Decimal fields split by ','.
+        RAW:XXXX XXXX ...       Hex words split by blanks or ',', "0x" is allowed.
+        MACRO:<item>; ...       Commands with *N and @<name>, or WAIT:<ms>.
+
+        Blanks around the prefix, the fields and the words are ignored.
+
+        Pronto bodies written by irdb/make.py are "XXXX XXXX ...", four hex
+        digits and one space per word. Runs in that layout are decoded in
+        bulk (IR_DecodeHexRun), 16 characters (3 words) at a time on SSE2 or
+        NEON, one table lookup per digit otherwise. A group that doesn't fit
+        the layout stops the run and goes through from_chars like any other
+        token, which is also what rejects malformed ones.
+*/
+
+// Whitespace the database may put around anything.
+inline bool IR_IsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline std::string_view IR_TrimView(std::string_view s)
+{
+    while (!s.empty() && IR_IsBlank(s.front())) s.remove_prefix(1);
+    while (!s.empty() && IR_IsBlank(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+// Split "PREFIX:body" at the first ':', false if there is none.
+inline bool IR_SplitCommand(std::string_view data, std::string_view &prefix, std::string_view &body)
+{
+    data = IR_TrimView(data);
+    size_t colon = data.find(':');
+    if (colon == std::string_view::npos)
+        return false;
+
+    prefix = IR_TrimView(data.substr(0, colon));
+    body = data.substr(colon + 1);
+    return true;
+}
+
+// Case-insensitive compare against an uppercase ASCII prefix.
+inline bool IR_PrefixIs(std::string_view prefix, std::string_view upper)
+{
+    if (prefix.size() != upper.size())
+        return false;
+    for (size_t i = 0; i < prefix.size(); i++) {
+        char c = prefix[i];
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        if (c != upper[i])
+            return false;
+    }
+    return true;
+}
+
+// Parse a number that has to fill the whole view.
+template <typename T>
+inline bool IR_ParseNumber(std::string_view text, T &value, int base = 10)
+{
+    const char *end = text.data() + text.size();
+    std::from_chars_result result = std::from_chars(text.data(), end, value, base);
+    return !text.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+// Parse the decimal fields of a command body into fields[]. Returns the
+// number of fields, or -1 if one isn't a number or there are more than
+// capacity of them.
+inline int IR_ParseFields(std::string_view body, uint32_t *fields, int capacity)
+{
+    int count = 0;
+    while (true) {
+        size_t comma = body.find(',');
+        if (count == capacity ||
+            !IR_ParseNumber(IR_TrimView(body.substr(0, comma)), fields[count]))
+            return -1;
+        count++;
+
+        if (comma == std::string_view::npos)
+            return count;
+        body.remove_prefix(comma + 1);
+    }
+}
+
+// Value of every character as a hex digit, 0xFF if it isn't one.
+struct IR_HexTable {
+    uint8_t value[256];
+
+    constexpr IR_HexTable() : value()
+    {
+        for (int c = 0; c < 256; c++)
+            value[c] = (c >= '0' && c <= '9') ? (uint8_t)(c - '0') :
+                       (c >= 'A' && c <= 'F') ? (uint8_t)(c - 'A' + 10) :
+                       (c >= 'a' && c <= 'f') ? (uint8_t)(c - 'a' + 10) : 0xFF;
+    }
+};
+inline constexpr IR_HexTable IR_HexDigits{};
+
+// Decode four hex digits, false if one of them isn't.
+inline bool IR_DecodeHexWord(const char *text, uint16_t &word)
+{
+    uint8_t a = IR_HexDigits.value[(uint8_t)text[0]];
+    uint8_t b = IR_HexDigits.value[(uint8_t)text[1]];
+    uint8_t c = IR_HexDigits.value[(uint8_t)text[2]];
+    uint8_t d = IR_HexDigits.value[(uint8_t)text[3]];
+    if ((a | b | c | d) & 0xF0)
+        return false;
+
+    word = (uint16_t)((a << 12) | (b << 8) | (c << 4) | d);
+    return true;
+}
+
+#if defined(IR_HEX_SSE2) || defined(IR_HEX_NEON)
+// Check 16 characters are "XXXX XXXX XXXX " and convert every hex digit in
+// them to its value in nibbles[]. Character 15 isn't looked at.
+inline bool IR_DecodeHexGroups(const char *text, uint8_t *nibbles)
+{
+#if defined(IR_HEX_SSE2)
+    const __m128i v = _mm_loadu_si128((const __m128i *)text);
+
+    // Digits and (either case of) letters as 0-9 and 0-5, anything else wraps past.
+    __m128i digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    int hex = _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter));
+    int blank = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    if ((hex & 0x3DEF) != 0x3DEF || (blank & 0x4210) != 0x4210)
+        return false;
+
+    __m128i value = _mm_or_si128(_mm_and_si128(isDigit, digit),
+                                 _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+    _mm_storeu_si128((__m128i *)nibbles, value);
+    return true;
+#else
+    static const uint8_t hexLanes[16]   = { 0xFF, 0xFF, 0xFF, 0xFF, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0 };
+    static const uint8_t blankLanes[16] = { 0, 0, 0, 0, 0xFF, 0, 0, 0, 0, 0xFF, 0, 0, 0, 0, 0xFF, 0 };
+    const uint8x16_t v = vld1q_u8((const uint8_t *)text);
+
+    uint8x16_t digit = vsubq_u8(v, vdupq_n_u8('0'));
+    uint8x16_t letter = vsubq_u8(vorrq_u8(v, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isDigit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t isLetter = vcleq_u8(letter, vdupq_n_u8(5));
+
+    // Every lane has to be what its position calls for.
+    uint8x16_t hexOk = vornq_u8(vorrq_u8(isDigit, isLetter), vld1q_u8(hexLanes));
+    uint8x16_t blankOk = vornq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vld1q_u8(blankLanes));
+    if (vminvq_u8(vandq_u8(hexOk, blankOk)) != 0xFF)
+        return false;
+
+    vst1q_u8(nibbles, vbslq_u8(isDigit, digit, vaddq_u8(letter, vdupq_n_u8(10))));
+    return true;
+#endif
+}
+#endif
+
+// Decode the "XXXX XXXX ..." run at the start of text, one word at a time.
+// Returns the words written to words[] and sets consumed to the characters
+// they took (each with its space), stopping at the first group that isn't
+// four hex digits followed by a space or the end.
+inline int IR_DecodeHexRunScalar(const char *text, size_t length, uint16_t *words, int capacity, size_t &consumed)
+{
+    int count = 0;
+    size_t pos = 0;
+    while (count < capacity && length - pos >= 4) {
+        bool last = (length - pos == 4);
+        if (!last && text[pos + 4] != ' ')
+            break;
+        if (!IR_DecodeHexWord(text + pos, words[count]))
+            break;
+
+        count++;
+        pos += last ? 4 : 5;
+    }
+
+    consumed = pos;
+    return count;
+}
+
+// Same as IR_DecodeHexRunScalar, three words at a time where there's SIMD.
+inline int IR_DecodeHexRun(const char *text, size_t length, uint16_t *words, int capacity, size_t &consumed)
+{
+    int count = 0;
+    size_t pos = 0;
+
+#if defined(IR_HEX_SSE2) || defined(IR_HEX_NEON)
+    uint8_t nibbles[16];
+    while (length - pos >= 16 && capacity - count >= 3 && IR_DecodeHexGroups(text + pos, nibbles)) {
+        for (int g = 0; g < 15; g += 5)
+            words[count++] = (uint16_t)((nibbles[g] << 12) | (nibbles[g + 1] << 8) |
+                                        (nibbles[g + 2] << 4) | nibbles[g + 3]);
+        pos += 15;
+    }
+#endif
+
+    size_t tail;
+    count += IR_DecodeHexRunScalar(text + pos, length - pos, words + count, capacity - count, tail);
+    consumed = pos + tail;
+    return count;
+}
+
+// Parse the hex words of a "RAW:" body into words[]. Returns the number of
+// words, or -1 if one isn't a 16 bit hex number or there are more than
+// capacity of them.
+inline int IR_ParseHexWords(std::string_view body, uint16_t *words, int capacity)
+{
+    int count = 0;
+    size_t pos = 0;
+    while (true) {
+        size_t consumed;
+        count += IR_DecodeHexRun(body.data() + pos, body.size() - pos, words + count, capacity - count, consumed);
+        pos += consumed;
+
+        while (pos < body.size() && (IR_IsBlank(body[pos]) || body[pos] == ','))
+            pos++;
+        if (pos == body.size())
+            return count;
+
+        size_t end = pos;
+        while (end < body.size() && !IR_IsBlank(body[end]) && body[end] != ',')
+            end++;
+
+        std::string_view word = body.substr(pos, end - pos);
+        if (word.size() > 2 && word[0] == '0' && (word[1] == 'x' || word[1] == 'X'))
+            word.remove_prefix(2);
+
+        if (count == capacity || !IR_ParseNumber(word, words[count], 16))
+            return -1;
+        count++;
+        pos = end;
+    }
+}
+
+// One item of a macro body, see MACROS in irdb.cpp for the layout.
+struct IR_MacroItem {
+    std::string_view command;   // Empty for a WAIT.
+    std::string_view device;    // After '@', empty if not given.
+    uint32_t presses;           // After '*', 1 if not given.
+    uint32_t wait_ms;           // WAIT:<ms>, 0 otherwise.
+};
+
+// Take the next item off the front of a macro body ("MACRO:" cut off),
+// skipping empty ones. Returns false once the body is used up. error is
+// set if the item is no good (a count or delay that isn't a number, a
+// macro inside the macro), NULL otherwise.
+inline bool IR_NextMacroItem(std::string_view &body, IR_MacroItem &item, const char *&error)
+{
+    std::string_view text;
+    while (text.empty()) {
+        if (IR_TrimView(body).empty())
+            return false;
+
+        size_t semicolon = body.find(';');
+        text = IR_TrimView(body.substr(0, semicolon));
+        body = (semicolon == std::string_view::npos) ? std::string_view() : body.substr(semicolon + 1);
+    }
+
+    item = IR_MacroItem{ {}, {}, 1, 0 };
+    error = nullptr;
+
+    // The delay has to fit in microseconds.
+    std::string_view prefix, rest;
+    if (IR_SplitCommand(text, prefix, rest) && IR_PrefixIs(prefix, "WAIT")) {
+        if (!IR_ParseNumber(IR_TrimView(rest), item.wait_ms) || item.wait_ms > UINT32_MAX / 1000)
+            error = "bad WAIT in macro";
+        return true;
+    }
+    if (IR_PrefixIs(prefix, "MACRO")) {
+        error = "macro inside a macro";
+        return true;
+    }
+
+    size_t at = text.rfind('@');
+    if (at != std::string_view::npos) {
+        item.device = IR_TrimView(text.substr(at + 1));
+        text = IR_TrimView(text.substr(0, at));
+        if (item.device.empty()) {
+            error = "bad device name in macro";
+            return true;
+        }
+    }
+
+    size_t star = text.rfind('*');
+    if (star != std::string_view::npos) {
+        if (!IR_ParseNumber(IR_TrimView(text.substr(star + 1)), item.presses) || item.presses == 0) {
+            error = "bad press count in macro";
+            return true;
+        }
+        text = IR_TrimView(text.substr(0, star));
+    }
+
+    item.command = text;
+    if (text.empty())
+        error = "empty command in macro";
+    return true;
+}
+
+#endif // WIIIR_DATA_PARSE_H
@@ -21,6 +21,7 @@
 #include <gccore.h>
 #include <wiiuse/wpad.h>
 #include <ogc/wiilaunch.h>
+#include <ogc/lwp_watchdog.h>
 #else
 #define _XML_NO_MSXML
 #include <msxml.h>
@@ -50,6 +51,7 @@ typedef int64_t   s64;
 #include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
+#include <memory>
 #include "imgui.h"
 #endif
 
@@ -93,7 +95,9 @@ enum {
     IR_PROTO_SHARP,
     IR_PROTO_XSAT,
     IR_PROTO_KASEIKYO,
-    IR_PROTO_RAW
+    IR_PROTO_RAW,
+    IR_PROTO_PRONTO,
+    IR_PROTO_COUNT
 };
 
 // Enum for device types
@@ -214,6 +218,10 @@ typedef struct {
 #define IR_KASEIKYO_LOGICAL_1 2250 // 2.250mS
 #define IR_KASEIKYO_LOGICAL_0 1125 // 1.125mS
 #define IR_KASEIKYO_SPACE 560 // 0.560mS
+#define IR_KASEIKYO_CAR_FREQ (float)37.0f
+#define IR_KASEIKYO_UNIT 432 // 0.432mS, every Kaseikyo timing is a multiple of it.
+#define IR_KASEIKYO_FRAME_PERIOD 130000 // 130mS, start to start.
+#define IR_KASEIKYO_VENDOR_PANASONIC 0x2002
 
 // RC6
 #define IR_RC6_PERIOD_US 36 // Total period (high + low) for 36 kHz in microseconds
@@ -221,11 +229,20 @@ typedef struct {
 #define IR_RC6_LEADER_PULSE_BURST 2666 // 2.666mS
 #define IR_RC6_LEADER 889 // 0.889mS
 #define IR_RC6_NORMAL 444 // 0.444mS
+#define IR_RC6_CAR_FREQ (float)36.0f
+#define IR_RC6_FRAME_PERIOD 106700 // 106.7mS, start to start.
+#define IR_RC6_MODE_0 0 // 8-bit address, 8-bit command.
+#define IR_RC6_MODE_6 6 // 6A, 32 bits (RC6X).
 
 // RC5
 #define IR_RC5_PERIOD_US 36 // Total period (high + low) for 36 kHz in microseconds
 #define IR_RC5_PERIOD_US_HALF 36 // Half period: 36 µs for each high or low state (50% duty cycle)
 #define IR_RC5_BURST 889 // 0.889mS
+#define IR_RC5_CAR_FREQ (float)36.0f
+#define IR_RC5_FRAME_PERIOD 113778 // 113.778mS (64 bit times), start to start.
+
+// Bi-phase frames, worst case entries (every half-bit its own edge).
+#define IR_BIPHASE_MAX_EDGES 80
 
 // SIRC
 typedef enum {
@@ -239,6 +256,7 @@ typedef enum {
 #define IR_SIRC_LOGICAL_1 1200 // 1.20mS
 #define IR_SIRC_BURST 600 // 0.60mS
 #define IR_SIRC_SPACE 2400 // 2.40mS
+#define IR_SIRC_FRAME_PERIOD 45000 // 45mS, start to start.
 
 // NEC
 #define IR_NEC_CAR_FREQ  (float)38.0f // Carrier freq in kHZ.
@@ -263,6 +281,7 @@ typedef enum {
 #define IR_SAMSUNG32_LOGICAL_1 1690 // 1.69mS
 #define IR_SAMSUNG32_LOGICAL_0 560  // 590uS
 #define IR_SAMSUNG32_STOP      560  // 590uS
+#define IR_SAMSUNG32_FRAME_PERIOD 108000 // 108mS, start to start.
 
 // JVC
 #define IR_JVC_CAR_FREQ  (float)38.0f   // 38KHz Carrier
@@ -271,11 +290,424 @@ typedef enum {
 #define IR_JVC_BURST     526            // 526uS
 #define IR_JVC_LOGICAL_1 2100           // 2.10mS
 #define IR_JVC_LOGICAL_0 1050           // 1.05mS
+#define IR_JVC_STOP      526            // 526uS, closes the last bit.
+#define IR_JVC_FRAME_PERIOD 55000       // 55mS, start to start (held key repeats too).
 
 // Define constants for Pronto format.
 #define PRONTO_FREQCALC_FLOAT_VAL           (float)0.241246  // Frequency calculation constant.
 #define PRONTO_SIGTYPE_RAWIR_MODULATED      (u16)0x0000 // Modulated raw IR signal.
 #define PRONTO_SIGTYPE_RAWIR_NOTMODULATED   (u16)0x0100 // Non-modulated raw IR signal.
+#define PRONTO_SIGTYPE_RC5                  (u16)0x5000 // RC5, system and command.
+#define PRONTO_SIGTYPE_RC6                  (u16)0x6000 // RC6 mode 0, system and command.
+#define PRONTO_SIGTYPE_NEC1                 (u16)0x900A // NEC1, device and command (each with its complement).
+#define PRONTO_UNIT_PICOS                   241246ULL   // Pronto clock tick, 0.241246uS.
+
+// A command as protocol, address and command, for the native encoders.
+typedef struct {
+    u16 protocol;       // IR_PROTO_*, SIRC's width is part of it.
+    u16 address;
+    u16 command;
+    u16 vendor;         // Kaseikyo vendor code, 0 for everything else.
+} ir_code_t;
+
+// Timebase.
+// Every edge of a frame is scheduled against an absolute deadline on this clock.
+#ifdef NINTENDOWII
+#define IR_TIMEBASE_HZ ((u64)TB_TIMER_CLOCK * 1000ULL) // Broadway timebase (60.75MHz).
+#else
+#define IR_TIMEBASE_HZ 1000000000ULL // CLOCK_MONOTONIC, in nanoseconds.
+#endif
+#define IR_WAIT_SPIN_US 200 // Default stretch at the end of every wait that is spun instead of slept.
+
+// Pluggable clock, lets the host run frames against a fake timebase.
+typedef struct {
+    u64  (*now)(void *ctx);
+    void (*wait_until)(void *ctx, u64 deadline);
+    void *ctx;
+} ir_clock_t;
+
+// Virtual clock, only advances when waited on.
+typedef struct {
+    u64 ticks;
+} ir_virtual_clock_t;
+
+void IR_SetClock(const ir_clock_t *clock); // NULL restores the system timebase.
+void IR_VirtualClockInit(ir_clock_t *clock, ir_virtual_clock_t *state);
+u64 IR_TimeNow(void);
+u64 IR_MicrosToTicks(u64 us);
+u64 IR_TicksToNanos(u64 ticks);
+void IR_WaitUntil(u64 deadline);
+void IR_SpinUntil(u64 deadline);
+void IR_SetWaitMargin(u32 margin_us);
+
+// Output backends.
+#define IR_BACKEND_MODULATED 0x01 // Wants every carrier cycle, not just the mark/space envelope.
+#define IR_GPIO_MIN_PULSE_US 5    // Sensor bar LED driver, switching on and back off with some margin.
+
+typedef struct {
+    const char *name;
+    void (*set_level)(void *ctx, u32 level);
+    void *ctx;
+    u32 flags;
+    u32 min_pulse_us;       // Shortest mark or space it gets out, 0 for no limit.
+} ir_backend_t;
+
+// Edge recorder backend.
+typedef struct {
+    u64 time;               // Timebase ticks.
+    u8  level;              // LED on/off.
+} ir_edge_t;
+
+typedef struct {
+    ir_edge_t *edges;       // Preallocated ring buffer.
+    u32 capacity;
+    u32 head;               // Next slot to write.
+    u32 total;              // Edges recorded since the last clear.
+    u8  level;              // Current LED level.
+} ir_edge_recorder_t;
+
+extern const ir_backend_t IR_BackendGPIO;
+extern const ir_backend_t IR_BackendNull;
+
+void IR_SetBackend(const ir_backend_t *backend); // NULL restores the platform default.
+const ir_backend_t *IR_GetBackend(void);
+void IR_EdgeRecorderInit(ir_backend_t *backend, ir_edge_recorder_t *recorder, ir_edge_t *buffer, u32 capacity, bool modulated);
+void IR_EdgeRecorderClear(ir_edge_recorder_t *recorder);
+u32 IR_EdgeRecorderCount(const ir_edge_recorder_t *recorder);
+const ir_edge_t *IR_EdgeRecorderGet(const ir_edge_recorder_t *recorder, u32 index);
+void IR_EdgeRecorderDump(const ir_edge_recorder_t *recorder, FILE *out);
+
+// Carrier generator.
+// Timing is cached per (frequency, duty) pair in whole timebase ticks, the
+// fractional part of the period is spread over the cycles Bresenham-style.
+#define IR_CARRIER_CACHE_SIZE 8
+
+typedef struct {
+    u32 frequency_hz;       // Carrier frequency (cache key).
+    u16 duty_permille;      // Duty cycle in 1/1000ths (cache key).
+    u32 period_ticks;       // Whole ticks per cycle.
+    u32 period_rem;         // Leftover ticks per cycle, in 1/frequency_hz units.
+    u32 on_ticks;           // LED on time per cycle.
+} ir_carrier_t;
+
+const ir_carrier_t *IR_CarrierLookup(u32 frequency_hz, u16 duty_permille);
+void IR_CarrierBurst(const ir_carrier_t *carrier, u64 start, u64 end);
+
+// Edge timing of the last played frame.
+typedef struct {
+    u32 edges;              // Mark/space edges scheduled.
+    u32 late_edges;         // Edges that landed after their deadline.
+    u32 worst_error_ns;     // Worst per-edge error, either way.
+    s32 mean_error_ns;      // Average per-edge error (negative = early).
+    u32 frame_us;           // Scheduled frame length.
+    u32 max_irq_off_us;     // Longest stretch with interrupts masked.
+    u16 protocol;           // IR_PROTO_* of the frame.
+} ir_timing_report_t;
+
+// Edge error left over after calibration, summed per protocol over every
+// frame played so far. Drift in here means the correction table is stale.
+typedef struct {
+    u32 frames;
+    u32 edges;
+    u32 late_edges;
+    s64 total_error_ns;     // Divide by edges for the mean.
+    u32 worst_error_ns;
+} ir_residual_t;
+
+void IR_GetTimingReport(ir_timing_report_t *report);
+void IR_GetResidual(u16 protocol, ir_residual_t *residual);
+void IR_ResetResiduals(void);
+
+// Timing calibration.
+// Every edge costs a backend call plus however long the wait loop takes to
+// notice its deadline, so left alone every edge lands that much late. The
+// calibration pass measures both on the active backend and the player
+// starts each edge early by the total.
+#define IR_CALIBRATE_SAMPLES     256  // set_level calls / spin waits timed.
+#define IR_CALIBRATE_SLEEPS      8    // usleep calls timed.
+#define IR_CALIBRATE_SLEEP_US    1000 // Length of each timed usleep.
+#define IR_CALIBRATE_SLACK_US    50   // Added on top of the worst oversleep.
+
+typedef struct {
+    const ir_backend_t *backend;  // Backend the table was measured on.
+    u32 set_level_ticks;    // Average cost of one set_level call.
+    u32 spin_late_ticks;    // Average overshoot of a spin wait.
+    u32 lead_ticks;         // Taken off every mark and space deadline.
+    u32 sleep_late_us;      // Worst usleep oversleep.
+    u32 wait_margin_us;     // Spin margin handed to IR_WaitUntil.
+} ir_calibration_t;
+
+bool IR_Calibrate(ir_calibration_t *calibration);
+void IR_SetCalibration(const ir_calibration_t *calibration); // NULL drops the corrections.
+const ir_calibration_t *IR_GetCalibration(void);
+
+// Interrupt masking while transmitting.
+typedef enum {
+    IR_IRQ_MASK_MARKS = 0,  // Mask around marks only, yield in long spaces.
+    IR_IRQ_MASK_FRAME       // Mask for the whole frame.
+} IRMode_IRQ;
+
+#define IR_IRQ_YIELD_SPACE_US 2000 // Spaces at least this long hand the CPU back to other threads.
+#define IR_IRQ_GUARD_US       250  // Interrupts are masked again this long before the next mark.
+
+void IR_SetIrqMode(IRMode_IRQ mode);
+
+// Pulse trains.
+// A compiled frame: alternating mark/space durations in microseconds,
+// always starting with a mark (even index = mark, odd index = space).
+#define IR_PULSE_TRAIN_MAX 256 // Enough for any fixed protocol frame.
+
+typedef struct {
+    u32  *durations;            // Mark/space durations (uS).
+    u32   count;                // Durations in use.
+    u32   capacity;             // Size of the durations buffer.
+    u32   carrier_hz;           // Carrier frequency in Hz.
+    u16   duty_permille;        // Carrier duty cycle (0 - 1000).
+    u16   protocol;             // IR_PROTO_* the frame was encoded as.
+    u32   period_us;            // Start to start spacing of back to back frames (0 = none).
+} ir_pulse_train_t;
+
+void IR_PulseTrainInit(ir_pulse_train_t *train, u32 *buffer, u32 capacity);
+void IR_PulseTrainCarrier(ir_pulse_train_t *train, float carrier_frequency, float duty_cycle);
+bool IR_PulseTrainMark(ir_pulse_train_t *train, u32 duration_us);
+bool IR_PulseTrainSpace(ir_pulse_train_t *train, u32 duration_us);
+void IR_PlayPulseTrain(const ir_pulse_train_t *train);
+
+// Peephole pass over a compiled train, see peephole.c.
+typedef struct {
+    u32 edges_before;
+    u32 edges_after;
+    u32 zeros_dropped;      // Zero length entries (and leading silence).
+    u32 spaces_folded;      // Spaces too short for the backend, folded into their marks.
+    u32 marks_clamped;      // Marks moved to whole carrier cycles or the backend minimum.
+} ir_peephole_report_t;
+
+void IR_PulseTrainOptimize(ir_pulse_train_t *train, const ir_backend_t *backend, ir_peephole_report_t *report);
+
+// Edge streams.
+// A frame that is generated a window at a time while it plays instead of
+// being compiled up front, so it takes the same memory however long it is
+// (air conditioner frames run to hundreds of bits). The payload is split in
+// sections, each sent with its own header and trailer, a gap between them.
+#define IR_STREAM_WINDOW        32 // Durations generated at a time, must be even.
+#define IR_STREAM_MAX_BYTES     64 // Payload, 512 bits.
+#define IR_STREAM_MAX_SECTIONS  4
+
+typedef struct {
+    u32 header_mark;        // 0 for no header.
+    u32 header_space;
+    u32 zero_mark;
+    u32 zero_space;
+    u32 one_mark;
+    u32 one_space;
+    u32 trailer_mark;       // 0 for no trailer (single section only).
+    u32 gap_space;          // Between sections.
+} ir_bit_timing_t;
+
+// Packed raw signals.
+// Raw captures only use a handful of distinct durations, so a signal is
+// kept as a table of them and an index per duration, 4 bits each if there
+// are 16 or fewer, 8 bits otherwise. The frame and its repeat sequence (if
+// any) share the table and one index stream, frame first. One allocation,
+// from IR_RawDictPack, freed with IR_RawDictFree.
+#define IR_RAW_DICT_MAX         256 // Most distinct durations a signal can have.
+
+typedef struct {
+    u32 carrier_hz;
+    u16 duty_permille;
+    u16 protocol;
+    u16 frame;              // Durations in the frame.
+    u16 repeat;             // Durations in the repeat sequence, 0 for none.
+    u16 sizes;              // Distinct durations in table.
+    u8  bits;               // Index width, 4 or 8.
+    const u32 *table;
+    const u8  *indices;     // At 4 bits, low nibble first.
+} ir_raw_dict_t;
+
+ir_raw_dict_t *IR_RawDictPack(const ir_pulse_train_t *frame, const ir_pulse_train_t *repeat);
+void IR_RawDictFree(ir_raw_dict_t *dict);
+u32 IR_RawDictBytes(const ir_raw_dict_t *dict);
+u32 IR_RawDictAt(const ir_raw_dict_t *dict, u32 position);
+bool IR_RawDictUnpack(const ir_raw_dict_t *dict, bool repeat, ir_pulse_train_t *train);
+
+typedef struct {
+    ir_pulse_train_t train;                     // The current window, what the player reads.
+    u32 window[IR_STREAM_WINDOW];
+
+    ir_bit_timing_t timing;
+    u8  payload[IR_STREAM_MAX_BYTES];           // Sent LSB first.
+    u8  section_end[IR_STREAM_MAX_SECTIONS];    // Payload offset each section ends at.
+    u8  sections;
+
+    // Packed raw source, played instead of the payload if set.
+    const ir_raw_dict_t *raw;   // Must outlive the stream.
+    bool raw_repeat;            // Play the repeat sequence (the frame if there's none).
+    u16 raw_end;
+
+    // Generator position.
+    u8  section;
+    u8  stage;
+    u16 bit;                    // Position in the index stream for raw sources.
+} ir_edge_stream_t;
+
+void IR_StreamInit(ir_edge_stream_t *stream, const ir_bit_timing_t *timing, u16 protocol, u32 period_us);
+bool IR_StreamAddSection(ir_edge_stream_t *stream, const u8 *bytes, u32 length);
+bool IR_StreamRewind(ir_edge_stream_t *stream);
+bool IR_StreamFill(ir_edge_stream_t *stream);
+bool IR_StreamRender(ir_edge_stream_t *stream, ir_pulse_train_t *train);
+void IR_StreamInitRaw(ir_edge_stream_t *stream, const ir_raw_dict_t *raw, bool repeat);
+
+// Pulse train player, plays a frame in steps.
+// IR_PlayerRun plays until the frame ends or a long space is reached; in the
+// latter case interrupts are back on and it should be called again at
+// IR_PlayerWakeTime() to carry on.
+typedef struct {
+    const ir_pulse_train_t *train;
+    const ir_carrier_t *carrier;
+    ir_edge_stream_t *stream; // Set if train is a stream window.
+    u32 index;              // Next duration to play.
+    u32 played;             // Durations played from earlier windows.
+    u64 frame_start;        // Frame start on the timebase.
+    u64 elapsed_us;         // Scheduled time up to the next edge.
+    u64 resume_at;          // Deadline of the next edge once yielded.
+    bool yield;             // Long spaces run with interrupts enabled.
+    u64 lead;               // Calibrated head start for every edge.
+    u64 edge_cost;          // Calibrated time from the wait ending to the LED switching.
+
+    // Interrupt state.
+    bool masked;
+    u32 irq_level;
+    u64 mask_start;
+
+    // Statistics.
+    u32 late_edges;
+    u64 worst_error;
+    s64 total_error;
+    u64 max_irq_off;
+} ir_player_t;
+
+bool IR_PlayerStart(ir_player_t *player, const ir_pulse_train_t *train, u64 start);
+bool IR_PlayerStartStream(ir_player_t *player, ir_edge_stream_t *stream, u64 start);
+bool IR_PlayerStarted(const ir_player_t *player);
+bool IR_PlayerRun(ir_player_t *player);
+u64 IR_PlayerWakeTime(const ir_player_t *player);
+u64 IR_PlayerNextStart(const ir_player_t *player);
+void IR_PlayerFinish(ir_player_t *player);
+
+// Macros.
+// A sequence of frames, compiled once into a schedule: every frame has its
+// start from the start of the macro, as early as the protocol spacing
+// allows (see the transmitter) plus any delay asked for. The transmitter
+// then plays the lot from one submission, on that schedule.
+// IR_MacroInterleave packs frames for different devices into each other's
+// trailing gaps, steps stay in the order they're played in.
+#define IR_MACRO_MAX_STEPS  64
+
+typedef struct {
+    const ir_pulse_train_t *frame;  // Must outlive the macro.
+    const ir_pulse_train_t *toggled; // Frame with the toggle bit flipped, NULL if the protocol has none.
+    const ir_raw_dict_t *raw;       // Packed signal, played instead of frame if set.
+    u32 device;                     // Frames of one device keep its spacing.
+    u32 delay_us;                   // Asked for on top of the spacing, holds back everything after it.
+    u32 offset_us;                  // Start, from the start of the first frame.
+    u32 length_us;                  // Trailing space included.
+    u32 active_us;                  // Up to the end of the last mark.
+} ir_macro_step_t;
+
+typedef struct {
+    ir_macro_step_t steps[IR_MACRO_MAX_STEPS];
+    u32 count;
+    u32 length_us;                  // Start of the first frame to the end of the last.
+    u32 serial_us;                  // The same, one frame after the other.
+} ir_macro_t;
+
+void IR_MacroInit(ir_macro_t *macro);
+bool IR_MacroAdd(ir_macro_t *macro, const ir_pulse_train_t *frame, const ir_pulse_train_t *toggled, const ir_raw_dict_t *raw, u32 device, u32 delay_us);
+u32 IR_MacroInterleave(ir_macro_t *macro);
+
+// Background transmitter.
+#define IR_TX_TRAIN_MAX     1024  // Longest frame the transmitter will take.
+#define IR_TX_QUEUE_DEPTH   4     // Frames that can be waiting at once.
+#define IR_TX_LEAD_US       500   // Gap between submitting a frame and its first edge.
+#define IR_TX_GAP_US        10000 // Silence between frames of different protocols.
+#define IR_TX_MIN_ALARM_NS  1000  // Shortest alarm we bother arming.
+#define IR_TX_PRIORITY      100   // LWP priority of the transmit thread, above the worker.
+#define IR_TX_STACK_SIZE    (8*1024)
+
+// The carrier is bit-banged, so the transmit thread keeps the CPU for every
+// mark and every space shorter than IR_IRQ_YIELD_SPACE_US. Interrupts are
+// serviced in those spaces, but lower priority threads (the UI included)
+// only run in the long ones, a NEC frame still holds them off for about
+// 55ms of its 108ms period.
+
+// IR_TxSubmit flags.
+#define IR_TX_REPEAT        0x01  // Repeat once per frame period until IR_TxStopRepeat.
+#define IR_TX_CANCEL        0x02  // Cancel anything pending first.
+
+typedef enum {
+    IR_TX_IDLE = 0,
+    IR_TX_QUEUED,
+    IR_TX_ACTIVE,
+    IR_TX_DONE,
+    IR_TX_CANCELLED
+} IRState_TX;
+
+typedef struct {
+    volatile u32 state;     // IRState_TX
+} ir_tx_handle_t;
+
+bool IR_TransmitterInit(void);
+void IR_TransmitterShutdown(void);
+bool IR_TxSubmit(const ir_pulse_train_t *frame, const ir_pulse_train_t *repeat, u32 flags, ir_tx_handle_t *handle);
+bool IR_TxSubmitStream(const ir_edge_stream_t *stream, u32 flags, ir_tx_handle_t *handle);
+void IR_SendStream(const ir_edge_stream_t *stream);
+bool IR_TxSubmitMacro(const ir_macro_t *macro, u32 flags, ir_tx_handle_t *handle);
+bool IR_PlayPulseTrainAsync(const ir_pulse_train_t *train, ir_tx_handle_t *handle);
+void IR_SendPulseTrain(const ir_pulse_train_t *train);
+bool IR_PlayPulseTrainRepeat(const ir_pulse_train_t *frame, const ir_pulse_train_t *repeat, ir_tx_handle_t *handle);
+void IR_TxStopRepeat(void);
+void IR_TxCancel(void);
+bool IR_TxBusy(void);
+void IR_TxWait(ir_tx_handle_t *handle);
+
+// Transmit worker.
+// Input and UI code hand already compiled commands to a worker thread
+// through a lock-free single producer / single consumer ring, the worker
+// does the logging and talks to the transmitter.
+#define IR_WORKER_QUEUE_DEPTH   32   // Must be a power of two.
+#define IR_WORKER_IDLE_US       2000 // Longest the worker sleeps without a wake-up.
+#define IR_WORKER_PRIORITY      80   // LWP priority, above the main thread.
+#define IR_WORKER_STACK_SIZE    (16*1024)
+
+typedef enum {
+    IR_CMD_SEND = 0,        // Send the frame once.
+    IR_CMD_PRESS,           // Send the frame, then repeat until IR_CMD_RELEASE.
+    IR_CMD_RELEASE,         // Stop repeating.
+    IR_CMD_CANCEL           // Drop everything pending.
+} IRCommand_Action;
+
+typedef struct {
+    u32 action;                         // IRCommand_Action
+    const ir_pulse_train_t *frame;      // Must outlive the command.
+    const ir_pulse_train_t *repeat;     // Repeat code, NULL repeats the frame.
+    const char *label;                  // For the log, may be NULL.
+    const ir_raw_dict_t *raw;           // Packed signal, played instead of frame and repeat if set.
+    const ir_macro_t *macro;            // Played instead of all of the above if set, never repeats.
+} ir_command_t;
+
+typedef struct {
+    u32 depth;              // Commands waiting right now.
+    u32 max_depth;          // Deepest the ring has been.
+    u32 enqueued;
+    u32 dropped;            // Ring full, or the worker wasn't running.
+    u32 processed;
+    u32 occupancy_permille; // Share of its time the worker spent busy.
+} ir_worker_stats_t;
+
+bool IR_WorkerStart(void);
+void IR_WorkerStop(void);
+bool IR_WorkerEnqueue(const ir_command_t *command);
+void IR_WorkerGetStats(ir_worker_stats_t *stats);
 
 // Base IR
 void _IR_SET_GPIO(u32 gpio, u32 value);
@@ -283,23 +715,46 @@ void IR_Transmit(float carrier_frequency, int duration_us, float duty_cycle);
 
 // Pronto Codes.
 float _pronto_calculate_frequency(uint16_t carrier_code);
+bool IR_CompilePronto(const uint16_t *pronto, size_t length, ir_pulse_train_t *frame, ir_pulse_train_t *repeat);
+bool IR_EncodePronto(ir_pulse_train_t *train, const uint16_t *pronto, size_t length);
+bool IR_ProntoDecode(const uint16_t *pronto, size_t length, ir_code_t *code);
 void IR_SendPronto(const uint16_t *pronto, size_t length);
 
 // NEC(ext) protocol(s).
+void IR_EncodeRepeatNEC(ir_pulse_train_t *train);
+void IR_EncodeByteNEC(ir_pulse_train_t *train, u8 byte, bool inverse);
+void IR_EncodeNECext(ir_pulse_train_t *train, u8 adrl, u8 adrm, u8 datal, u8 datam, bool invert_dm);
+void IR_EncodeNEC(ir_pulse_train_t *train, u8 adr, u8 data);
 void IR_RepeatNEC();
-void IR_SendByteNEC(u8 byte, bool inverse);
 void IR_SendNECext(u8 adrl, u8 adrm, u8 datal, u8 datam, bool invert_dm);
 void IR_SendNEC(u8 adr, u8 data);
 
 // Sony SIRC Protocol
+bool IR_EncodeSIRC(ir_pulse_train_t *train, IRMode_SIRC mode, u8 address, u16 data);
 void IR_SendSIRC(IRMode_SIRC mode, u8 address, u16 data);
 
 // Samsung32 Protocol
+void IR_EncodeSamsung32(ir_pulse_train_t *train, uint8_t address, uint8_t command);
 void IR_SendSamsung32(uint8_t address, uint8_t command);
 
 // JVC Protocol
+void IR_EncodeJVC(ir_pulse_train_t *train, uint8_t address, uint8_t command);
+void IR_EncodeRepeatJVC(ir_pulse_train_t *train, uint8_t address, uint8_t command);
 void IR_SendJVC(uint8_t address, uint8_t command);
 
+// Kaseikyo (Panasonic) Protocol
+bool IR_EncodeKaseikyo(ir_edge_stream_t *stream, u16 vendor, u16 address, u8 command);
+void IR_SendKaseikyo(u16 vendor, u16 address, u8 command);
+
+// RC5, RC6 and RC6X (bi-phase) Protocols
+bool IR_NextToggle(u16 protocol);
+bool IR_EncodeRC5(ir_pulse_train_t *train, u8 address, u8 command, bool toggle);
+bool IR_EncodeRC6(ir_pulse_train_t *train, u8 address, u8 command, bool toggle);
+bool IR_EncodeRC6X(ir_pulse_train_t *train, u16 address, u16 command, bool toggle);
+void IR_SendRC5(u8 address, u8 command);
+void IR_SendRC6(u8 address, u8 command);
+void IR_SendRC6X(u16 address, u16 command);
+
 // IRDB
 void load_json_and_convert(const char *filename);
 void run_irdb(const char *filename);
@@ -382,6 +837,8 @@ struct ButtonEntry {
     std::string name;                // "Power Button"
     std::vector<MapEntry> maps;      // list of maps
     std::string data;                // "NEC:32,122" or RAW codes
+    std::shared_ptr<ir_raw_dict_t> raw; // RAW codes packed at load time, data is dropped then.
+    ir_code_t code = { IR_PROTO_COUNT, 0, 0, 0 }; // data parsed at load time, IR_PROTO_COUNT if it's not a protocol command.
 };
 
 struct DeviceEntry {
@@ -399,6 +856,8 @@ struct XMLDatabase {
 };
 
 XMLDatabase LoadXML(const char* filename, const char* customFile = nullptr);
+u32 LintXML(const XMLDatabase &db);
+void SetVerboseIR(bool verbose); // Trace every command compile (encoder calls, peephole results).
 void DrawXMLBrowser(XMLDatabase& db, ImGuiWindowFlags &window_flags);
 #endif
 
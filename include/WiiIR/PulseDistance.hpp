@@ -0,0 +1,168 @@
+// PulseDistance.hpp - (C)2025 Dakota Thorpe.
+// Compile-time encoders for pulse-distance (NEC, JVC, Samsung) and pulse-width (SIRC) protocols.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+#ifndef WIIIR_PULSE_DISTANCE_H
+#define WIIIR_PULSE_DISTANCE_H
+
+#include <stddef.h>
+#include <utility>
+#include "WiiIR/IR.hpp"
+
+// Order the bits of a field go out in.
+typedef enum {
+    IR_LSB_FIRST = 0,
+    IR_MSB_FIRST
+} IRMode_BitOrder;
+
+// Everything about a pulse-distance/pulse-width protocol except its fields.
+// A bit is a mark followed by a space, 0 and 1 differ in either (or both).
+typedef struct {
+    u16 protocol;           // IRProtocol, for the timing report.
+    u32 carrier_hz;
+    u16 duty_permille;
+    u32 header_mark;        // 0 for no header.
+    u32 header_space;
+    u32 zero_mark;
+    u32 zero_space;
+    u32 one_mark;
+    u32 one_space;
+    IRMode_BitOrder order;
+    u32 trailer_mark;       // 0 for no trailer.
+    u32 period_us;          // Start to start, 0 if the protocol has none.
+} ir_pulse_distance_t;
+
+// Encoder for one protocol (P) and field layout (Widths, in bits, in the
+// order they are sent). Everything but the field values is known at compile
+// time, so each instance is a straight run of stores into the timing buffer:
+// the bit loops unroll and the per-bit choice is a mask, not a branch.
+//
+//     static constexpr ir_pulse_distance_t IR_PD_FOO = { ... };
+//     IR_PulseDistance<IR_PD_FOO, 8, 8>::Encode(train, address, command);
+template <const ir_pulse_distance_t &P, u8... Widths>
+struct IR_PulseDistance {
+    static_assert(((Widths >= 1 && Widths <= 32) && ...), "Field widths must be 1 to 32 bits");
+    static_assert(P.header_mark != 0 || P.header_space == 0, "A header space needs a header mark");
+
+    static constexpr u32 fields = sizeof...(Widths);
+    static constexpr u32 bits = (0u + ... + Widths);
+    static constexpr u32 length = (P.header_mark ? 2 : 0) + bits * 2 + (P.trailer_mark ? 1 : 0);
+
+    // Append the frame to train and take on the protocol's carrier and
+    // period, returns false (leaving the train alone) if it doesn't fit.
+    template <typename... Values>
+    static bool Encode(ir_pulse_train_t *train, Values... values)
+    {
+        if (!Append(train, values...))
+            return false;
+
+        train->carrier_hz = P.carrier_hz;
+        train->duty_permille = P.duty_permille;
+        train->protocol = P.protocol;
+        train->period_us = P.period_us;
+        return true;
+    }
+
+    // Append the timings only.
+    template <typename... Values>
+    static bool Append(ir_pulse_train_t *train, Values... values)
+    {
+        static_assert(sizeof...(Values) == fields, "One value per field");
+
+        if (train->count + length > train->capacity) {
+            printf("Error: Pulse train overflow (%u entries).\n", (unsigned)train->capacity);
+            return false;
+        }
+
+        u32 *out = train->durations + train->count;
+        if constexpr (P.header_mark != 0) {
+            out[0] = P.header_mark;
+            out[1] = P.header_space;
+            out += 2;
+        }
+
+        const u32 field_values[fields + 1] = { (u32)values..., 0 };
+        EmitFields(out, field_values, std::make_index_sequence<fields>{});
+        out += bits * 2;
+
+        if constexpr (P.trailer_mark != 0)
+            out[0] = P.trailer_mark;
+
+        // A train that ended on a mark takes the first mark of this frame
+        // into it, the same way IR_PulseTrainMark folds two marks together.
+        if (train->count & 1) {
+            u32 *frame = train->durations + train->count;
+            frame[-1] += frame[0];
+            memmove(frame, frame + 1, (length - 1) * sizeof(u32));
+            train->count += length - 1;
+        } else {
+            train->count += length;
+        }
+        return true;
+    }
+
+private:
+    // Branchless pick between the 0 and 1 timing, folds away when they match.
+    static constexpr u32 Pick(u32 bit, u32 zero, u32 one)
+    {
+        return zero ^ ((zero ^ one) & (0u - bit));
+    }
+
+    static constexpr u32 Width(size_t field)
+    {
+        constexpr u8 widths[fields + 1] = { Widths..., 0 };
+        return widths[field];
+    }
+
+    // Bits sent before the given field.
+    static constexpr u32 Offset(size_t field)
+    {
+        constexpr u8 widths[fields + 1] = { Widths..., 0 };
+        u32 offset = 0;
+        for (size_t i = 0; i < field; i++)
+            offset += widths[i];
+        return offset;
+    }
+
+    template <u32 W, u32... Bit>
+    static inline void EmitBits(u32 *out, u32 value, std::integer_sequence<u32, Bit...>)
+    {
+        ((out[Bit * 2]     = Pick((value >> (P.order == IR_LSB_FIRST ? Bit : W - 1 - Bit)) & 1, P.zero_mark, P.one_mark),
+          out[Bit * 2 + 1] = Pick((value >> (P.order == IR_LSB_FIRST ? Bit : W - 1 - Bit)) & 1, P.zero_space, P.one_space)), ...);
+    }
+
+    template <size_t... Field>
+    static inline void EmitFields(u32 *out, const u32 *values, std::index_sequence<Field...>)
+    {
+        (EmitBits<Width(Field)>(out + Offset(Field) * 2, values[Field],
+                                std::make_integer_sequence<u32, Width(Field)>{}), ...);
+    }
+};
+
+#endif // WIIIR_PULSE_DISTANCE_H
@@ -54,6 +54,8 @@ def get_protocol_info(protocol):
         return {"supported": True, "address_length": 2, "command_length": 1}
     elif protocol == "SAMSUNG32":
         return {"supported": True, "address_length": 1, "command_length": 1}
+    elif protocol in ("RC5", "RC5X", "RC6"):
+        return {"supported": True, "address_length": 1, "command_length": 1}
     else:
         return {"supported": False, "address_length": 0, "command_length": 0}
 
@@ -81,6 +81,7 @@
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_sdlrenderer2.h"
 #include "WiiIR/IR.hpp"
+#include "WiiIR/DataParse.hpp"
 #include "stb/stb_image_resize2.h"
 #include <stdio.h>
 
@@ -103,6 +104,12 @@
 #include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
+#include <string_view>
+#include <atomic>
+
+#ifndef NINTENDOWII
+#include <thread>
+#endif
 
 using namespace tinyxml2;
 namespace fs = std::filesystem;
@@ -125,213 +132,878 @@ static inline std::string trim(const std::string &s)
     return s.substr(start, end - start + 1);
 }
 
-// Convert "0000" → integer
-static inline u16 hexToUInt16(const std::string &hex)
+// Compile traces (encoder calls, peephole results and the like), off
+// unless SetVerboseIR(true). Errors are printed either way.
+static std::atomic<bool> verboseIR(false);
+#define IR_VERBOSE(...) do { if (verboseIR) printf(__VA_ARGS__); } while (0)
+
+void SetVerboseIR(bool verbose)
+{
+    verboseIR = verbose;
+}
+
+// Most Pronto words a RAW entry can have, the header and a frame and
+// repeat as long as the transmitter takes.
+#define IR_PRONTO_MAX_WORDS (4 + 2 * IR_TX_TRAIN_MAX)
+
+// The Pronto words of a "RAW:" entry into words[] (IR_PRONTO_MAX_WORDS),
+// the count or -1 if it isn't one.
+static int ParseRawEntry(std::string_view data, u16 *words)
+{
+    std::string_view prefix, body;
+    if (!IR_SplitCommand(data, prefix, body) || !IR_PrefixIs(prefix, "RAW"))
+        return -1;
+    return IR_ParseHexWords(body, words, IR_PRONTO_MAX_WORDS);
+}
+
+// Rewrite a coded Pronto entry (RC5, RC6 or NEC1) as the native command it
+// stands for, e.g. "RAW:900A 006C 0000 0001 04FB 08F7" -> "NEC:4,8".
+// Raw timing and everything else is left alone. Returns true if rewritten.
+static bool LowerCodedPronto(std::string &data)
+{
+    u16 pronto[IR_PRONTO_MAX_WORDS];
+    int count = ParseRawEntry(data, pronto);
+    ir_code_t code;
+    if (count < 0 || !IR_ProntoDecode(pronto, count, &code))
+        return false;
+
+    const char *prefix;
+    switch (code.protocol) {
+        case IR_PROTO_RC5:    prefix = "RC5";    break;
+        case IR_PROTO_RC6:    prefix = "RC6";    break;
+        case IR_PROTO_NEC:    prefix = "NEC";    break;
+        case IR_PROTO_NECext: prefix = "NECext"; break;
+        default: return false;
+    }
+
+    char lowered[32];
+    snprintf(lowered, sizeof(lowered), "%s:%u,%u", prefix, code.address, code.command);
+    data = lowered;
+    return true;
+}
+
+// Run the peephole pass (see peephole.c) over a compiled train for the
+// current backend.
+static void OptimizeTrain(const char *what, ir_pulse_train_t &train)
+{
+    if (train.count == 0)
+        return;
+
+    ir_peephole_report_t report;
+    IR_PulseTrainOptimize(&train, IR_GetBackend(), &report);
+    IR_VERBOSE("[SendIR] Peephole %s: %u -> %u edges (%u zero, %u folded, %u marks clamped).\n",
+                   what, report.edges_before, report.edges_after,
+                   report.zeros_dropped, report.spaces_folded, report.marks_clamped);
+}
+
+// Compile a raw timing entry and pack it (see IR_RawDictPack), NULL if
+// it's not one or doesn't compile. Coded entries are lowered instead.
+static std::shared_ptr<ir_raw_dict_t> PackRawSignal(const std::string &data)
+{
+    u16 pronto[IR_PRONTO_MAX_WORDS];
+    int count = ParseRawEntry(data, pronto);
+    ir_code_t code;
+    if (count <= 4 || IR_ProntoDecode(pronto, count, &code))
+        return nullptr;
+
+    // Only needed until it's packed.
+    u32 capacity = (u32)count - 4;
+    std::vector<u32> frameDurations(capacity), repeatDurations(capacity);
+    ir_pulse_train_t frame, repeat;
+    IR_PulseTrainInit(&frame, frameDurations.data(), capacity);
+    IR_PulseTrainInit(&repeat, repeatDurations.data(), capacity);
+    if (!IR_CompilePronto(pronto, count, &frame, &repeat))
+        return nullptr;
+
+    // Whole carrier cycles also leave fewer distinct durations to pack.
+    OptimizeTrain("RAW frame", frame);
+    OptimizeTrain("RAW repeat", repeat);
+
+    ir_raw_dict_t *dict = IR_RawDictPack(&frame, &repeat);
+    if (!dict)
+        return nullptr;
+    return std::shared_ptr<ir_raw_dict_t>(dict, IR_RawDictFree);
+}
+
+// Raw signals packed while loading, and the text they replaced.
+static u32 packedSignals = 0;
+static size_t packedTextBytes = 0;
+static size_t packedBytes = 0;
+
+// Pack a RAW entry and drop its text, which is most of a raw heavy
+// database. Anything else is left as it is.
+static void PackRawEntry(ButtonEntry &btn)
 {
-    return (u16)strtol(hex.c_str(), nullptr, 16);
+    btn.raw = PackRawSignal(btn.data);
+    if (!btn.raw)
+        return;
+
+    packedSignals++;
+    packedTextBytes += btn.data.size();
+    packedBytes += IR_RawDictBytes(btn.raw.get());
+    std::string().swap(btn.data);
 }
 
+// A command compiled into ready to play frames. Built the first time the
+// command is sent and replayed from here on, so a held key never parses or
+// encodes anything.
+struct CompiledIR {
+    std::vector<u32> frameDurations;
+    std::vector<u32> repeatDurations;
+    std::vector<u32> toggledDurations;
+    ir_pulse_train_t frame;
+    ir_pulse_train_t repeat;        // Repeat code, if the protocol has one.
+    ir_pulse_train_t toggled;       // Frame with the toggle bit set, if the protocol has one.
+    std::shared_ptr<ir_raw_dict_t> raw; // Packed raw signal, played instead of the trains.
+    std::shared_ptr<ir_macro_t> macro;  // Played instead of everything else if set.
+    bool hasRepeat = false;
+    bool hasToggle = false;
+    bool valid = false;
+};
+
+// Keyed by the command string, entries never move once inserted.
+static std::unordered_map<std::string, CompiledIR> compiledCache;
+
+// Protocol commands, keyed by their parsed protocol, vendor, address and command.
+static std::unordered_map<u64, CompiledIR> codedCache;
+
+// Buttons packed at load time, keyed by their signal.
+static std::unordered_map<const ir_raw_dict_t*, CompiledIR> packedCache;
+
 // --------------------------------------------------------------------------------------------
-// SEND IR MAIN FUNCTION
+// PROTOCOL ENCODERS
 // --------------------------------------------------------------------------------------------
-void SendIR(const std::string &dataString)
+// Each one encodes a parsed command into its frame and, where the protocol
+// has one, the repeat frame sent while the key is held (repeat.count stays
+// 0 if not) and the frame with the toggle bit flipped (toggled.count stays 0
+// if not).
+typedef bool (*ir_encode_fn)(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &repeat,
+                             ir_pulse_train_t &toggled);
+
+static bool EncodeNEC(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &repeat, ir_pulse_train_t &)
+{
+    IR_VERBOSE("[SendIR] Calling IR_EncodeNEC(%u, %u)\n", (u8)code.address, (u8)code.command);
+    IR_EncodeNEC(&train, (u8)code.address, (u8)code.command);
+    IR_EncodeRepeatNEC(&repeat);
+    return true;
+}
+
+static bool EncodeNECext(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &repeat, ir_pulse_train_t &)
+{
+    u8 adrLo = code.address & 0xFF;
+    u8 adrHi = (code.address >> 8) & 0xFF;
+
+    IR_VERBOSE("[SendIR] Calling IR_EncodeNECext(%u, %u, %u, %u)\n", adrLo, adrHi, (u8)code.command, (u8)code.command);
+    IR_EncodeNECext(&train, adrLo, adrHi, (u8)code.command, (u8)code.command, true);
+    IR_EncodeRepeatNEC(&repeat);
+    return true;
+}
+
+static bool EncodeSamsung32(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &, ir_pulse_train_t &)
+{
+    IR_VERBOSE("[SendIR] Calling IR_EncodeSamsung32(%u, %u)\n", (u8)code.address, (u8)code.command);
+    IR_EncodeSamsung32(&train, (u8)code.address, (u8)code.command);
+    return true;
+}
+
+static bool EncodeJVC(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &repeat, ir_pulse_train_t &)
+{
+    IR_VERBOSE("[SendIR] Calling IR_EncodeJVC(%u, %u)\n", (u8)code.address, (u8)code.command);
+    IR_EncodeJVC(&train, (u8)code.address, (u8)code.command);
+    IR_EncodeRepeatJVC(&repeat, (u8)code.address, (u8)code.command);
+    return true;
+}
+
+// The width comes from the protocol, the command's high byte is SIRC20's
+// extended byte.
+static bool EncodeSIRC(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &, ir_pulse_train_t &)
+{
+    IRMode_SIRC mode = (code.protocol == IR_PROTO_SIRC20) ? IR_SIRC_MODE_20 :
+                       (code.protocol == IR_PROTO_SIRC15) ? IR_SIRC_MODE_15 : IR_SIRC_MODE_12;
+
+    IR_VERBOSE("[SendIR] Calling IR_EncodeSIRC(SONY%u, %u, %u)\n",
+               (mode == IR_SIRC_MODE_20) ? 20u : (mode == IR_SIRC_MODE_15) ? 15u : 12u,
+               (u8)code.address, code.command);
+    return IR_EncodeSIRC(&train, mode, (u8)code.address, code.command);
+}
+
+static bool EncodeRC5(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &, ir_pulse_train_t &toggled)
+{
+    IR_VERBOSE("[SendIR] Calling IR_EncodeRC5(%u, %u)\n", (u8)code.address, (u8)code.command);
+    return IR_EncodeRC5(&train, (u8)code.address, (u8)code.command, false) &&
+           IR_EncodeRC5(&toggled, (u8)code.address, (u8)code.command, true);
+}
+
+static bool EncodeRC6(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &, ir_pulse_train_t &toggled)
+{
+    IR_VERBOSE("[SendIR] Calling IR_EncodeRC6(%u, %u)\n", (u8)code.address, (u8)code.command);
+    return IR_EncodeRC6(&train, (u8)code.address, (u8)code.command, false) &&
+           IR_EncodeRC6(&toggled, (u8)code.address, (u8)code.command, true);
+}
+
+static bool EncodeRC6X(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &, ir_pulse_train_t &toggled)
+{
+    IR_VERBOSE("[SendIR] Calling IR_EncodeRC6X(%u, %u)\n", code.address, code.command);
+    return IR_EncodeRC6X(&train, code.address, code.command, false) &&
+           IR_EncodeRC6X(&toggled, code.address, code.command, true);
+}
+
+static bool EncodeKaseikyo(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &, ir_pulse_train_t &)
 {
-    std::string data = trim(dataString);
+    // Short enough to keep, the stream is rendered into the frame.
+    IR_VERBOSE("[SendIR] Calling IR_EncodeKaseikyo(0x%04X, %u, %u)\n", code.vendor, code.address, (u8)code.command);
+    ir_edge_stream_t stream;
+    return IR_EncodeKaseikyo(&stream, code.vendor, code.address, (u8)code.command) &&
+           IR_StreamRender(&stream, &train);
+}
+
+// --------------------------------------------------------------------------------------------
+// PROTOCOL REGISTRY
+// --------------------------------------------------------------------------------------------
+// A protocol command type, "<PREFIX>:address,command".
+struct IRProtocol {
+    const char *prefix;     // Uppercase, without the ':'.
+    const char *name;       // For the log.
+    u16 protocol;           // IR_PROTO_*
+    u32 addressMask;        // Bits the address and command may have set.
+    u32 commandMask;
+    bool hasVendor;         // Takes an optional vendor before the address.
+    u16 vendor;             // Vendor when it's left out.
+    ir_encode_fn encode;
+};
+
+// Looked up by prefix when parsing, by IR_PROTO_* when encoding. Both are a
+// single lookup however many protocols there are.
+static std::unordered_map<std::string_view, IRProtocol> protocolsByPrefix;
+static const IRProtocol *protocolsById[IR_PROTO_COUNT];
+
+static void RegisterProtocol(const char *prefix, const char *name, u16 protocol, ir_encode_fn encode,
+                             u32 addressMask, u32 commandMask, bool hasVendor = false, u16 vendor = 0)
+{
+    IRProtocol &entry = protocolsByPrefix[prefix];
+    entry = { prefix, name, protocol, addressMask, commandMask, hasVendor, vendor, encode };
+
+    // Aliases ("RC5X") leave the first name in place.
+    if (!protocolsById[protocol])
+        protocolsById[protocol] = &entry;
+}
+
+// Every protocol command the database can use. A new protocol is an
+// encoder above and one line here.
+static void RegisterProtocols()
+{
+    RegisterProtocol("NEC",       "NEC",       IR_PROTO_NEC,       EncodeNEC,       0xFF,   0xFF);
+    RegisterProtocol("NECEXT",    "NECext",    IR_PROTO_NECext,    EncodeNECext,    0xFFFF, 0xFF);
+    RegisterProtocol("SAMSUNG32", "Samsung32", IR_PROTO_SAMSUNG32, EncodeSamsung32, 0xFF,   0xFF);
+    RegisterProtocol("JVC",       "JVC",       IR_PROTO_JVC,       EncodeJVC,       0xFF,   0xFF);
+    RegisterProtocol("SIRC",      "SIRC12",    IR_PROTO_SIRC12,    EncodeSIRC,      0x1F,   0x7F);
+    RegisterProtocol("SIRC12",    "SIRC12",    IR_PROTO_SIRC12,    EncodeSIRC,      0x1F,   0x7F);
+    RegisterProtocol("SIRC15",    "SIRC15",    IR_PROTO_SIRC15,    EncodeSIRC,      0xFF,   0x7F);
+    RegisterProtocol("SIRC20",    "SIRC20",    IR_PROTO_SIRC20,    EncodeSIRC,      0x1F,   0xFF7F);
+    RegisterProtocol("RC5",       "RC5",       IR_PROTO_RC5,       EncodeRC5,       0x1F,   0x7F);
+    RegisterProtocol("RC5X",      "RC5",       IR_PROTO_RC5,       EncodeRC5,       0x1F,   0x7F);
+    RegisterProtocol("RC6",       "RC6",       IR_PROTO_RC6,       EncodeRC6,       0xFF,   0xFF);
+    RegisterProtocol("RC6X",      "RC6X",      IR_PROTO_RC6X,      EncodeRC6X,      0xFFFF, 0x7FFF);
+
+    // KASEIKYO:address,command (Panasonic) or KASEIKYO:vendor,address,command
+    RegisterProtocol("KASEIKYO",  "Kaseikyo",  IR_PROTO_KASEIKYO,  EncodeKaseikyo,  0xFFF,  0xFF,
+                     true, IR_KASEIKYO_VENDOR_PANASONIC);
+}
+
+// Filled in once, during static init (before main and before any thread
+// can exist). From then on the registry is only ever read, so the worker,
+// the UI and the lint threads can all look things up without a lock.
+static const bool protocolsRegistered = (RegisterProtocols(), true);
+
+// The registered protocol for a command's prefix, NULL for RAW, MACRO and
+// anything unknown.
+static const IRProtocol *FindProtocol(std::string_view prefix)
+{
+    char upper[16];
+    if (prefix.size() > sizeof(upper))
+        return nullptr;
+    for (size_t i = 0; i < prefix.size(); i++)
+        upper[i] = (char)toupper((unsigned char)prefix[i]);
+
+    auto it = protocolsByPrefix.find(std::string_view(upper, prefix.size()));
+    return (it != protocolsByPrefix.end()) ? &it->second : nullptr;
+}
+
+// --------------------------------------------------------------------------------------------
+// IR COMMAND PARSER
+// --------------------------------------------------------------------------------------------
+// Split a protocol command's body into fields[] ([vendor,] address,
+// command). NULL if that worked, otherwise what's wrong with it.
+static const char *SplitCommandFields(const IRProtocol *type, std::string_view body, u32 *fields, int &count)
+{
+    count = IR_ParseFields(body, fields, 3);
+    if (count < 0)
+        return "a field isn't a number";
+    if (count != 2 && !(type->hasVendor && count == 3))
+        return type->hasVendor ? "expected [vendor,]address,command" : "expected address,command";
+    return nullptr;
+}
+
+// Parse a protocol command ("NEC:4,8", "KASEIKYO:8194,32,1") into its typed
+// form. Done once per button when the database loads, so pressing one never
+// touches the string. Doesn't allocate (see DataParse.hpp). False for RAW,
+// MACRO and anything malformed.
+static bool ParseCommand(std::string_view data, ir_code_t &code)
+{
+    std::string_view prefix, body;
+    if (!IR_SplitCommand(data, prefix, body))
+        return false;
+
+    const IRProtocol *type = FindProtocol(prefix);
+    if (!type)
+        return false;
+
+    u32 fields[3];
+    int count;
+    if (const char *problem = SplitCommandFields(type, body, fields, count)) {
+        IR_VERBOSE("[SendIR] Invalid %s format (%s): %.*s\n", type->name, problem, (int)data.size(), data.data());
+        return false;
+    }
+
+    code.protocol = type->protocol;
+    code.address = (u16)fields[count - 2];
+    code.command = (u16)fields[count - 1];
+    code.vendor = (count == 3) ? (u16)fields[0] : type->vendor;
+    return true;
+}
+
+// Everything done to a button once when it's loaded: coded Pronto is
+// lowered, raw timing packed and protocol commands parsed into btn.code.
+static void PrepareButtonEntry(ButtonEntry &btn)
+{
+    btn.code.protocol = IR_PROTO_COUNT;
+    LowerCodedPronto(btn.data);
+    PackRawEntry(btn);
+    if (!btn.raw)
+        ParseCommand(btn.data, btn.code);
+}
+
+// --------------------------------------------------------------------------------------------
+// IR COMMAND COMPILER
+// --------------------------------------------------------------------------------------------
+// Encode a parsed command with its protocol's encoder.
+static bool EncodeCode(const ir_code_t &code, ir_pulse_train_t &train, ir_pulse_train_t &repeat,
+                       ir_pulse_train_t &toggled)
+{
+    const IRProtocol *type = (code.protocol < IR_PROTO_COUNT) ? protocolsById[code.protocol] : nullptr;
+    if (!type) {
+        printf("[SendIR] No encoder for protocol %u.\n", code.protocol);
+        return false;
+    }
+    return type->encode(code, train, repeat, toggled);
+}
+
+// Compile a command string that isn't a protocol command (those are
+// parsed and encoded as above), i.e. RAW entries from their Pronto words.
+static bool EncodeIR(const std::string &dataString, ir_pulse_train_t &train, ir_pulse_train_t &repeat,
+                     ir_pulse_train_t &toggled)
+{
+    std::string_view data = IR_TrimView(dataString);
 
     if (data.empty()) {
         printf("[SendIR] Empty data string.\n");
-        return;
+        return false;
     }
 
-    // Uppercase a copy for type detection
-    std::string upper = data;
-    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-
     // ======================================================
-    // =================== NEC ==============================
+    // =================== RAW / PRONTO =====================
     // ======================================================
-    if (upper.rfind("NEC:", 0) == 0)
+    u16 pronto[IR_PRONTO_MAX_WORDS];
+    int count = ParseRawEntry(data, pronto);
+    if (count >= 0)
     {
-        printf("[SendIR] NEC packet: %s\n", data.c_str());
+        IR_VERBOSE("[SendIR] RAW packet: %.*s\n", (int)data.size(), data.data());
 
-        std::string body = data.substr(4);
-        size_t commaPos = body.find(',');
-        if (commaPos == std::string::npos) {
-            printf("[SendIR] Invalid NEC format.\n");
-            return;
+        if (count == 0) {
+            printf("[SendIR] No RAW/pronto data found.\n");
+            return false;
         }
 
-        std::string adrStr = trim(body.substr(0, commaPos));
-        std::string cmdStr = trim(body.substr(commaPos + 1));
-
-        uint8_t adr = (uint8_t)strtol(adrStr.c_str(), nullptr, 10);
-        uint8_t cmd = (uint8_t)strtol(cmdStr.c_str(), nullptr, 10);
+        // Coded signals are only a protocol, address and command.
+        ir_code_t code;
+        if (IR_ProntoDecode(pronto, count, &code)) {
+            IR_VERBOSE("[SendIR] Coded Pronto, protocol %u.\n", code.protocol);
+            return EncodeCode(code, train, repeat, toggled);
+        }
 
-        printf("[SendIR] Calling IR_SendNEC(%u, %u)\n", adr, cmd);
-        IR_SendNEC(adr, cmd);
-        return;
+        // The repeating sequence goes out again for as long as the key is held.
+        IR_VERBOSE("[SendIR] Calling IR_CompilePronto() with %d entries.\n", count);
+        return IR_CompilePronto(pronto, count, &train, &repeat);
     }
 
     // ======================================================
-    // =================== Samsung32 ========================
+    // =================== UNKNOWN TYPE =====================
     // ======================================================
-    if (upper.rfind("SAMSUNG32:", 0) == 0)
-    {
-        printf("[SendIR] Samsung32 packet: %s\n", data.c_str());
+    printf("[SendIR] Unknown IR format: %.*s\n", (int)data.size(), data.data());
+    return false;
+}
 
-        std::string body = data.substr(10);
-        size_t commaPos = body.find(',');
-        if (commaPos == std::string::npos) {
-            printf("[SendIR] Invalid Samsung32 format.\n");
-            return;
-        }
+static bool CompileMacro(const std::string &data, ir_macro_t &macro);
 
-        std::string adrStr = trim(body.substr(0, commaPos));
-        std::string cmdStr = trim(body.substr(commaPos + 1));
+// Run an encoder into scratch space, then keep only what it used.
+template <typename Encoder>
+static bool CompileTrains(CompiledIR &entry, Encoder encode)
+{
+    static u32 frameScratch[IR_TX_TRAIN_MAX];
+    static u32 repeatScratch[IR_PULSE_TRAIN_MAX];
+    static u32 toggledScratch[IR_PULSE_TRAIN_MAX];
+    ir_pulse_train_t frame, repeat, toggled;
+    IR_PulseTrainInit(&frame, frameScratch, IR_TX_TRAIN_MAX);
+    IR_PulseTrainInit(&repeat, repeatScratch, IR_PULSE_TRAIN_MAX);
+    IR_PulseTrainInit(&toggled, toggledScratch, IR_PULSE_TRAIN_MAX);
+
+    entry.valid = encode(frame, repeat, toggled);
+    if (!entry.valid)
+        return false;
+
+    OptimizeTrain("frame", frame);
+    OptimizeTrain("repeat", repeat);
+    OptimizeTrain("toggled", toggled);
+
+    entry.frameDurations.assign(frameScratch, frameScratch + frame.count);
+    entry.frame = frame;
+    entry.frame.durations = entry.frameDurations.data();
+    entry.frame.capacity = frame.count;
+
+    entry.hasRepeat = (repeat.count > 0);
+    entry.repeatDurations.assign(repeatScratch, repeatScratch + repeat.count);
+    entry.repeat = repeat;
+    entry.repeat.durations = entry.repeatDurations.data();
+    entry.repeat.capacity = repeat.count;
+
+    entry.hasToggle = (toggled.count > 0);
+    entry.toggledDurations.assign(toggledScratch, toggledScratch + toggled.count);
+    entry.toggled = toggled;
+    entry.toggled.durations = entry.toggledDurations.data();
+    entry.toggled.capacity = toggled.count;
+    return true;
+}
 
-        uint8_t adr = (uint8_t)strtol(adrStr.c_str(), nullptr, 10);
-        uint8_t cmd = (uint8_t)strtol(cmdStr.c_str(), nullptr, 10);
+// Look a parsed command up in the cache, compiling it on first use.
+// Returns NULL if the command doesn't compile.
+static const CompiledIR *GetCompiledIR(const ir_code_t &code)
+{
+    u64 key = ((u64)code.protocol << 48) | ((u64)code.vendor << 32) |
+              ((u64)code.address << 16) | code.command;
+    auto it = codedCache.find(key);
+    if (it != codedCache.end())
+        return it->second.valid ? &it->second : nullptr;
+
+    CompiledIR &entry = codedCache[key];
+    bool compiled = CompileTrains(entry, [&](ir_pulse_train_t &frame, ir_pulse_train_t &repeat, ir_pulse_train_t &toggled) {
+        return EncodeCode(code, frame, repeat, toggled);
+    });
+    return compiled ? &entry : nullptr;
+}
 
-        printf("[SendIR] Calling IR_SendSamsung32(%u, %u)\n", adr, cmd);
-        IR_SendSamsung32(adr, cmd);
-        return;
+// Look a command string up in the cache, compiling it on first use.
+// Returns NULL if the command doesn't compile.
+static const CompiledIR *GetCompiledIR(const std::string &data)
+{
+    // Protocol commands share one entry however they're spelled.
+    ir_code_t code;
+    if (ParseCommand(data, code))
+        return GetCompiledIR(code);
+
+    auto it = compiledCache.find(data);
+    if (it != compiledCache.end())
+        return it->second.valid ? &it->second : nullptr;
+
+    CompiledIR &entry = compiledCache[data];
+
+    // Macros compile every command in them, then the schedule.
+    std::string type = trim(data).substr(0, 6);
+    std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+    if (type == "MACRO:") {
+        entry.macro = std::make_shared<ir_macro_t>();
+        entry.valid = CompileMacro(data, *entry.macro);
+        if (!entry.valid)
+            return nullptr;
+
+        IR_VERBOSE("[SendIR] Macro compiled: %u frames, %u ms (%u ms one after the other, %u ms saved).\n",
+                   (unsigned)entry.macro->count, (unsigned)(entry.macro->length_us / 1000),
+                   (unsigned)(entry.macro->serial_us / 1000),
+                   (unsigned)((entry.macro->serial_us - entry.macro->length_us) / 1000));
+        return &entry;
     }
 
-    if (upper.rfind("SIRC:", 0) == 0)
-    {
-        printf("[SendIR] SIRC12 packet: %s\n", data.c_str());
+    // Raw timing stays packed, it's unpacked while it plays.
+    entry.raw = PackRawSignal(data);
+    if (entry.raw) {
+        entry.valid = true;
+        return &entry;
+    }
 
-        std::string body = data.substr(5);
-        size_t commaPos = body.find(',');
-        if (commaPos == std::string::npos) {
-            printf("[SendIR] Invalid SIRC format.\n");
-            return;
-        }
+    bool compiled = CompileTrains(entry, [&](ir_pulse_train_t &frame, ir_pulse_train_t &repeat, ir_pulse_train_t &toggled) {
+        return EncodeIR(data, frame, repeat, toggled);
+    });
+    return compiled ? &entry : nullptr;
+}
 
-        std::string adrStr = trim(body.substr(0, commaPos));
-        std::string cmdStr = trim(body.substr(commaPos + 1));
+// A button's command, straight from what was parsed or packed at load
+// time. Only macros and unparsed entries go through their string.
+static const CompiledIR *GetCompiledIR(const ButtonEntry &btn)
+{
+    if (btn.code.protocol != IR_PROTO_COUNT)
+        return GetCompiledIR(btn.code);
+    if (!btn.raw)
+        return GetCompiledIR(btn.data);
+
+    // Holding a reference keeps the signal alive for a queued frame.
+    CompiledIR &entry = packedCache[btn.raw.get()];
+    entry.raw = btn.raw;
+    entry.valid = true;
+    return &entry;
+}
 
-        uint8_t adr = (uint8_t)strtol(adrStr.c_str(), nullptr, 10);
-        uint16_t cmd = (uint16_t)strtol(cmdStr.c_str(), nullptr, 10);
+// The frame for a new key press. Protocols with a toggle bit alternate
+// between their two frames, repeats while held keep the same one.
+static const ir_pulse_train_t *PressFrame(const CompiledIR *ir)
+{
+    if (ir->hasToggle && IR_NextToggle(ir->frame.protocol))
+        return &ir->toggled;
+    return &ir->frame;
+}
 
-        printf("[SendIR] Calling IR_SendSIRC(SONY12, %u, %u)\n", adr, cmd);
-        IR_SendSIRC(IR_SIRC_MODE_12, adr, cmd);
-        return;
-    }
+// --------------------------------------------------------------------------------------------
+// MACROS
+// --------------------------------------------------------------------------------------------
+/*
+    MACRO:<command>; <command>; ...
+        Each command is any other command string, *N after it presses it N
+        times. WAIT:<ms> waits that much longer before the next command,
+        on top of the spacing the protocols need anyway.
 
-    if (upper.rfind("SIRC15:", 0) == 0)
-    {
-        printf("[SendIR] SIRC15 packet: %s\n", data.c_str());
+        MACRO:NEC:4,8; RC5:16,12; WAIT:1500; RC5:16,56; NEC:4,2*5
 
-        std::string body = data.substr(7);
-        size_t commaPos = body.find(',');
-        if (commaPos == std::string::npos) {
-            printf("[SendIR] Invalid SIRC format.\n");
-            return;
-        }
+    The commands are compiled (and cached) like any other, then laid out
+    in one schedule the transmitter plays in one go.
 
-        std::string adrStr = trim(body.substr(0, commaPos));
-        std::string cmdStr = trim(body.substr(commaPos + 1));
+    Frames for different devices are packed into each other's trailing
+    gaps, a device only has to wait for its own. A command's device is its
+    protocol and address ("NEC:4"), all RAW commands count as one device.
+    @<name> after a command (after *N) names its device instead.
 
-        uint8_t adr = (uint8_t)strtol(adrStr.c_str(), nullptr, 10);
-        uint16_t cmd = (uint16_t)strtol(cmdStr.c_str(), nullptr, 10);
+        MACRO:NEC:4,8@tv; SIRC:1,21@amp; NEC:4,2*5@tv
+*/
 
-        printf("[SendIR] Calling IR_SendSIRC(SONY15, %u, %u)\n", adr, cmd);
-        IR_SendSIRC(IR_SIRC_MODE_15, adr, cmd);
-        return;
+// The device a macro command is for, see above. Devices are numbered in
+// the order they first turn up in the macro, devices holds their names.
+static u32 MacroDevice(std::vector<std::string> &devices, std::string_view command, std::string_view name)
+{
+    std::string_view key = name;
+    if (key.empty()) {
+        std::string_view prefix, body;
+        IR_SplitCommand(command, prefix, body);
+        key = IR_PrefixIs(prefix, "RAW") ? std::string_view("RAW") : IR_TrimView(command.substr(0, command.find(',')));
     }
 
-    if (upper.rfind("SIRC20:", 0) == 0)
+    std::string upper(key);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    for (u32 i = 0; i < devices.size(); i++)
+        if (devices[i] == upper)
+            return i;
+
+    devices.push_back(std::move(upper));
+    return (u32)devices.size() - 1;
+}
+static bool CompileMacro(const std::string &data, ir_macro_t &macro)
+{
+    IR_MacroInit(&macro);
+
+    std::string_view prefix, body;
+    IR_SplitCommand(data, prefix, body);
+
+    IR_MacroItem item;
+    const char *problem;
+    std::vector<std::string> devices;
+    u32 delay_us = 0;
+
+    while (IR_NextMacroItem(body, item, problem))
     {
-        printf("[SendIR] SIRC20 packet: %s\n", data.c_str());
+        if (problem) {
+            printf("[SendIR] Invalid macro (%s): %s\n", problem, data.c_str());
+            return false;
+        }
+        if (item.command.empty()) {
+            if (item.wait_ms > (UINT32_MAX - delay_us) / 1000) {
+                printf("[SendIR] Invalid macro (WAIT too long): %s\n", data.c_str());
+                return false;
+            }
+            delay_us += item.wait_ms * 1000;
+            continue;
+        }
 
-        std::string body = data.substr(7);
-        size_t commaPos = body.find(',');
-        if (commaPos == std::string::npos) {
-            printf("[SendIR] Invalid SIRC format.\n");
-            return;
+        std::string command(item.command);
+        const CompiledIR *ir = GetCompiledIR(command);
+        if (!ir) {
+            printf("[SendIR] Macro command doesn't compile: %s\n", command.c_str());
+            return false;
         }
 
-        std::string adrStr = trim(body.substr(0, commaPos));
-        std::string cmdStr = trim(body.substr(commaPos + 1));
+        // Every press is a new one, the transmitter flips the toggle bit
+        // for each when the macro is played.
+        u32 key = MacroDevice(devices, item.command, item.device);
+        const ir_pulse_train_t *frame = ir->raw ? nullptr : &ir->frame;
+        const ir_pulse_train_t *toggled = ir->hasToggle ? &ir->toggled : nullptr;
+        for (u32 p = 0; p < item.presses; p++) {
+            if (!IR_MacroAdd(&macro, frame, toggled, ir->raw.get(), key, delay_us))
+                return false;
+            delay_us = 0;
+        }
+    }
+
+    if (macro.count == 0)
+        return false;
 
-        uint8_t adr = (uint8_t)strtol(adrStr.c_str(), nullptr, 10);
-        uint16_t cmd = (uint16_t)strtol(cmdStr.c_str(), nullptr, 10);
+    IR_MacroInterleave(&macro);
+    return true;
+}
 
-        printf("[SendIR] Calling IR_SendSIRC(SONY20, %u, %u)\n", adr, cmd);
-        IR_SendSIRC(IR_SIRC_MODE_12, adr, cmd);
+// --------------------------------------------------------------------------------------------
+// SEND IR MAIN FUNCTION
+// --------------------------------------------------------------------------------------------
+// Queue a command once, returns as soon as the worker has it. The frame
+// goes out at the earliest time the protocol spacing allows.
+void SendIR(const std::string &dataString)
+{
+    const CompiledIR *ir = GetCompiledIR(dataString);
+    if (!ir || !IR_WorkerStart())
         return;
-    }
 
-    // ======================================================
-    // =================== NEC EXTENDED =====================
-    // ======================================================
-    if (upper.rfind("NECEXT:", 0) == 0)
-    {
-        printf("[SendIR] NECext packet: %s\n", data.c_str());
+    ir_command_t command = { IR_CMD_SEND, PressFrame(ir), nullptr, nullptr, ir->raw.get(), ir->macro.get() };
+    if (!IR_WorkerEnqueue(&command))
+        printf("[SendIR] Worker queue full, command dropped.\n");
+}
 
-        std::string body = data.substr(7);
-        size_t commaPos = body.find(',');
-        if (commaPos == std::string::npos) {
-            printf("[SendIR] Invalid NECext format.\n");
-            return;
-        }
+// Measure the backend once, before the first frame goes out.
+static void CalibrateIR()
+{
+    if (IR_GetCalibration())
+        return;
 
-        std::string adrStr = trim(body.substr(0, commaPos));
-        std::string cmdStr = trim(body.substr(commaPos + 1));
+    ir_calibration_t calibration;
+    if (!IR_Calibrate(&calibration))
+        return;
 
-        int adrFull = strtol(adrStr.c_str(), nullptr, 10);
-        int cmdFull = strtol(cmdStr.c_str(), nullptr, 10);
+    printf("[IR] Calibrated on %s: set_level %u ns, spin overshoot %u ns, lead %u ns, sleep overshoot %u us.\n",
+           calibration.backend->name,
+           (unsigned)IR_TicksToNanos(calibration.set_level_ticks),
+           (unsigned)IR_TicksToNanos(calibration.spin_late_ticks),
+           (unsigned)IR_TicksToNanos(calibration.lead_ticks),
+           calibration.sleep_late_us);
+}
 
-        uint8_t adrLo = adrFull & 0xFF;
-        uint8_t adrHi = (adrFull >> 8) & 0xFF;
+// --------------------------------------------------------------------------------------------
+// DATABASE LINT
+// --------------------------------------------------------------------------------------------
+/*
+    DEV Notes:
+        Checks every button's <Data> without compiling or sending anything,
+        so bad entries show up when the database loads instead of when
+        someone presses the button.
+            Protocol commands - known prefix, field count, address and
+                                command within the protocol's widths.
+            RAW               - hex words, a known Pronto type, burst pairs
+                                that match the header exactly, no zero
+                                bursts and a 20-100 kHz carrier.
+            MACRO             - every command in it, as above.
+        Buttons are independent, so they're handed out in blocks to one
+        thread per core on the host. Broadway has one core, it lints in place.
+*/
 
-        printf("[SendIR] Calling IR_SendNECext(%u, %u, %u, %u)\n",
-               adrLo, adrHi, cmdFull, cmdFull);
+// Carrier range a real remote uses.
+#define IR_LINT_CARRIER_MIN_HZ  20000
+#define IR_LINT_CARRIER_MAX_HZ  100000
 
-        IR_SendNECext(adrLo, adrHi, cmdFull, cmdFull, true);
-        return;
-    }
+// Buttons a lint thread takes at a time.
+#define IR_LINT_BLOCK           256
 
-    // ======================================================
-    // =================== RAW / PRONTO =====================
-    // ======================================================
-    if (upper.rfind("RAW:", 0) == 0)
-    {
-        printf("[SendIR] RAW packet: %s\n", data.c_str());
+static const char *LintCarrier(u32 carrier_hz)
+{
+    if (carrier_hz < IR_LINT_CARRIER_MIN_HZ || carrier_hz > IR_LINT_CARRIER_MAX_HZ)
+        return "carrier outside 20-100 kHz";
+    return nullptr;
+}
 
-        std::string body = data.substr(4);
+// What's wrong with a Pronto body, NULL if nothing.
+static const char *LintPronto(std::string_view body)
+{
+    u16 pronto[IR_PRONTO_MAX_WORDS];
+    int count = IR_ParseHexWords(body, pronto, IR_PRONTO_MAX_WORDS);
+    if (count < 0)
+        return "bad Pronto word, or too many";
+    if (count < 4)
+        return "Pronto header missing";
+
+    if (pronto[0] == PRONTO_SIGTYPE_RC5 || pronto[0] == PRONTO_SIGTYPE_RC6 || pronto[0] == PRONTO_SIGTYPE_NEC1) {
+        ir_code_t code;
+        return IR_ProntoDecode(pronto, count, &code) ? nullptr : "coded Pronto fields out of range";
+    }
+    if (pronto[0] != PRONTO_SIGTYPE_RAWIR_MODULATED && pronto[0] != PRONTO_SIGTYPE_RAWIR_NOTMODULATED)
+        return "unknown Pronto type";
+    if (pronto[1] == 0)
+        return "no Pronto carrier";
+
+    size_t pairs = (size_t)pronto[2] + pronto[3];
+    if (pairs == 0)
+        return "no burst pairs";
+    if (4 + 2 * pairs != (size_t)count)
+        return "burst pairs don't match the header";
+    for (int i = 4; i < count; i++)
+        if (pronto[i] == 0)
+            return "zero length burst";
+
+    if (pronto[0] == PRONTO_SIGTYPE_RAWIR_MODULATED)
+        return LintCarrier((u32)(1000000000000ULL / ((u64)pronto[1] * PRONTO_UNIT_PICOS)));
+    return nullptr;
+}
 
-        std::stringstream ss(body);
-        std::string token;
+static const char *LintMacro(std::string_view body);
 
-        std::vector<u16> pronto;
+// What's wrong with a command, NULL if nothing.
+static const char *LintCommand(std::string_view data)
+{
+    std::string_view prefix, body;
+    if (IR_TrimView(data).empty())
+        return "empty <Data>";
+    if (!IR_SplitCommand(data, prefix, body))
+        return "no protocol prefix";
+
+    if (IR_PrefixIs(prefix, "RAW"))
+        return LintPronto(body);
+    if (IR_PrefixIs(prefix, "MACRO"))
+        return LintMacro(body);
+
+    const IRProtocol *type = FindProtocol(prefix);
+    if (!type)
+        return "unknown protocol";
+
+    u32 fields[3];
+    int count;
+    if (const char *problem = SplitCommandFields(type, body, fields, count))
+        return problem;
+    if (fields[count - 2] & ~type->addressMask)
+        return "address out of range";
+    if (fields[count - 1] & ~type->commandMask)
+        return "command out of range";
+    if (count == 3 && fields[0] > 0xFFFF)
+        return "vendor out of range";
+    return nullptr;
+}
 
-        while (ss >> token)
-        {
-            // Uppercase hex
-            std::string clean;
-            for (char c : token)
-                if (isxdigit(c)) clean += c;
+// Every command of a macro, see MACROS for the layout. Goes through the
+// same parser as CompileMacro, so they agree on what a macro is.
+static const char *LintMacro(std::string_view body)
+{
+    IR_MacroItem item;
+    const char *problem;
+    u32 commands = 0;
+    while (IR_NextMacroItem(body, item, problem))
+    {
+        if (problem)
+            return problem;
+        if (item.command.empty())
+            continue;
+        if ((problem = LintCommand(item.command)))
+            return problem;
+        commands++;
+    }
+    return commands ? nullptr : "empty macro";
+}
 
-            if (!clean.empty())
-                pronto.push_back(hexToUInt16(clean));
-        }
+static const char *LintButton(const ButtonEntry &btn)
+{
+    // Packed at load time, so its timing already compiled.
+    if (btn.raw)
+        return btn.raw->carrier_hz ? LintCarrier(btn.raw->carrier_hz) : nullptr;
+    return LintCommand(btn.data);
+}
 
-        if (pronto.empty()) {
-            printf("[SendIR] No RAW/pronto data found.\n");
-            return;
+// Lint every button in the database and print what's wrong, per
+// manufacturer. Returns the number of buttons with a problem.
+u32 LintXML(const XMLDatabase &db)
+{
+    struct LintItem {
+        u32 manufacturer;
+        const DeviceEntry *device;
+        const ButtonEntry *button;
+        const char *problem;
+    };
+
+    std::vector<LintItem> items;
+    for (u32 m = 0; m < db.manufacturers.size(); m++)
+        for (const DeviceEntry &dev : db.manufacturers[m].devices)
+            for (const ButtonEntry &btn : dev.buttons)
+                items.push_back({ m, &dev, &btn, nullptr });
+
+    u64 start = IR_TimeNow();
+    std::atomic<size_t> next(0);
+    auto lint = [&]() {
+        size_t first;
+        while ((first = next.fetch_add(IR_LINT_BLOCK)) < items.size()) {
+            size_t last = std::min(first + IR_LINT_BLOCK, items.size());
+            for (size_t i = first; i < last; i++)
+                items[i].problem = LintButton(*items[i].button);
         }
+    };
 
-        printf("[SendIR] Calling IR_SendPronto() with %d entries.\n", (int)pronto.size());
-        IR_SendPronto(pronto.data(), pronto.size());
-        return;
+#ifdef NINTENDOWII
+    u32 threads = 1;
+    lint();
+#else
+    u32 threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (u32 t = 1; t < threads; t++)
+        pool.emplace_back(lint);
+    lint();
+    for (std::thread &thread : pool)
+        thread.join();
+#endif
+    u64 elapsed_us = IR_TicksToNanos(IR_TimeNow() - start) / 1000;
+
+    // Items are in manufacturer order, report each one that has problems.
+    u32 total = 0;
+    for (size_t first = 0, last; first < items.size(); first = last)
+    {
+        u32 m = items[first].manufacturer;
+        u32 problems = 0;
+        for (last = first; last < items.size() && items[last].manufacturer == m; last++)
+            problems += (items[last].problem != nullptr);
+        if (!problems)
+            continue;
+
+        printf("[IRDB] Lint %s: %u of %u buttons have problems.\n",
+               db.manufacturers[m].name.c_str(), problems, (unsigned)(last - first));
+        u32 shown = 0;
+        for (size_t i = first; i < last && shown < 5; i++) {
+            if (!items[i].problem)
+                continue;
+            // Packed entries have given up their text, describe the signal instead.
+            const ButtonEntry &btn = *items[i].button;
+            if (btn.raw)
+                printf("    %s / %s: %s (packed RAW, %u Hz, %u edges + %u repeat)\n", items[i].device->name.c_str(),
+                       btn.name.c_str(), items[i].problem, (unsigned)btn.raw->carrier_hz,
+                       (unsigned)btn.raw->frame, (unsigned)btn.raw->repeat);
+            else
+                printf("    %s / %s: %s (%.40s%s)\n", items[i].device->name.c_str(), btn.name.c_str(),
+                       items[i].problem, btn.data.c_str(), (btn.data.size() > 40) ? "..." : "");
+            shown++;
+        }
+        if (problems > shown)
+            printf("    ... and %u more.\n", problems - shown);
+        total += problems;
     }
 
-    // ======================================================
-    // =================== UNKNOWN TYPE =====================
-    // ======================================================
-    printf("[SendIR] Unknown IR format: %s\n", data.c_str());
+    printf("[IRDB] Lint: %u buttons in %u.%03u ms on %u thread%s, %u with problems.\n",
+           (unsigned)items.size(), (unsigned)(elapsed_us / 1000), (unsigned)(elapsed_us % 1000),
+           threads, (threads == 1) ? "" : "s", total);
+    return total;
 }
 
 // --- Helper to merge custom maps into a button entry ---
@@ -352,6 +1024,7 @@ void MergeButtonEntry(ButtonEntry &btn, tinyxml2::XMLElement *customBtnNode) {
     tinyxml2::XMLElement* dataNode = customBtnNode->FirstChildElement("Data");
     if (dataNode && dataNode->GetText()) {
         btn.data = dataNode->GetText();
+        PrepareButtonEntry(btn);
     }
 }
 
@@ -519,6 +1192,9 @@ void ApplyCustomMaps(XMLDatabase &db, const char* customFile) {
 XMLDatabase LoadXML(const char* filename, const char* customFile) {
     XMLDatabase db;
     tinyxml2::XMLDocument doc;
+    packedSignals = 0;
+    packedTextBytes = 0;
+    packedBytes = 0;
 
     if (doc.LoadFile(filename) != XML_SUCCESS)
         throw std::runtime_error("Failed to load XML file.");
@@ -570,8 +1246,10 @@ XMLDatabase LoadXML(const char* filename, const char* customFile) {
 
                     // Data
                     tinyxml2::XMLElement* dataNode = b->FirstChildElement("Data");
-                    if (dataNode && dataNode->GetText())
+                    if (dataNode && dataNode->GetText()) {
                         btn.data = dataNode->GetText();
+                        PrepareButtonEntry(btn);
+                    }
 
                     dev.buttons.push_back(btn);
                 }
@@ -589,6 +1267,11 @@ XMLDatabase LoadXML(const char* filename, const char* customFile) {
     if (customFile)
         ApplyCustomMaps(db, customFile);
 
+    if (packedSignals)
+        printf("[IRDB] Packed %u RAW signals, %u bytes of text down to %u.\n",
+               packedSignals, (unsigned)packedTextBytes, (unsigned)packedBytes);
+
+    LintXML(db);
     return db;
 }
 
@@ -596,23 +1279,84 @@ XMLDatabase LoadXML(const char* filename, const char* customFile) {
 // TODO: Reimplement WiiIR header to have premapped button
 // definitions to avoid defining static string names in this
 // function.
+// Whether a mapped key is held down right now.
+static bool MapHeld(const MapEntry& map, u32 held)
+{
+#ifdef NINTENDOWII
+    // Wii Mappings
+    if (map.value == "WPAD_BUTTON_UP") return (held & WPAD_BUTTON_UP) != 0;
+    if (map.value == "WPAD_BUTTON_DOWN") return (held & WPAD_BUTTON_DOWN) != 0;
+    if (map.value == "WPAD_BUTTON_LEFT") return (held & WPAD_BUTTON_LEFT) != 0;
+    if (map.value == "WPAD_BUTTON_RIGHT") return (held & WPAD_BUTTON_RIGHT) != 0;
+    if (map.value == "WPAD_BUTTON_A") return (held & WPAD_BUTTON_A) != 0;
+    if (map.value == "WPAD_BUTTON_B") return (held & WPAD_BUTTON_B) != 0;
+    if (map.value == "WPAD_BUTTON_1") return (held & WPAD_BUTTON_1) != 0;
+    if (map.value == "WPAD_BUTTON_2") return (held & WPAD_BUTTON_2) != 0;
+    if (map.value == "WPAD_BUTTON_PLUS") return (held & WPAD_BUTTON_PLUS) != 0;
+    if (map.value == "WPAD_BUTTON_MINUS") return (held & WPAD_BUTTON_MINUS) != 0;
+    if (map.value == "WPAD_BUTTON_HOME") return (held & WPAD_BUTTON_HOME) != 0;
+    if (map.value == "WPAD_NUNCHUK_C") return (held & WPAD_NUNCHUK_BUTTON_C) != 0;
+    if (map.value == "WPAD_NUNCHUK_Z") return (held & WPAD_NUNCHUK_BUTTON_Z) != 0;
+    if (map.value == "WPAD_CLASSIC_BUTTON_A") return (held & WPAD_CLASSIC_BUTTON_A) != 0;
+    if (map.value == "WPAD_CLASSIC_BUTTON_B") return (held & WPAD_CLASSIC_BUTTON_B) != 0;
+    if (map.value == "WPAD_CLASSIC_BUTTON_X") return (held & WPAD_CLASSIC_BUTTON_X) != 0;
+    if (map.value == "WPAD_CLASSIC_BUTTON_Y") return (held & WPAD_CLASSIC_BUTTON_Y) != 0;
+    if (map.value == "WPAD_CLASSIC_BUTTON_ZL") return (held & WPAD_CLASSIC_BUTTON_ZL) != 0;
+    if (map.value == "WPAD_CLASSIC_BUTTON_ZR") return (held & WPAD_CLASSIC_BUTTON_ZR) != 0;
+    if (map.value == "WPAD_CLASSIC_BUTTON_FULL_L") return (held & WPAD_CLASSIC_BUTTON_FULL_L) != 0;
+    if (map.value == "WPAD_CLASSIC_BUTTON_FULL_R") return (held & WPAD_CLASSIC_BUTTON_FULL_R) != 0;
+#else
+    // Windows key mapping
+    (void)held;
+    if (map.value == "A") return (GetAsyncKeyState('A') & 0x8000) != 0;
+    if (map.value == "B") return (GetAsyncKeyState('B') & 0x8000) != 0;
+    if (map.value == "UP") return (GetAsyncKeyState(VK_UP) & 0x8000) != 0;
+    if (map.value == "DOWN") return (GetAsyncKeyState(VK_DOWN) & 0x8000) != 0;
+    if (map.value == "LEFT") return (GetAsyncKeyState(VK_LEFT) & 0x8000) != 0;
+    if (map.value == "RIGHT") return (GetAsyncKeyState(VK_RIGHT) & 0x8000) != 0;
+    if (map.value == "1") return (GetAsyncKeyState('1') & 0x8000) != 0;
+    if (map.value == "2") return (GetAsyncKeyState('2') & 0x8000) != 0;
+    if (map.value == "+") return (GetAsyncKeyState(VK_OEM_PLUS) & 0x8000) != 0;
+    if (map.value == "-") return (GetAsyncKeyState(VK_OEM_MINUS) & 0x8000) != 0;
+    if (map.value == "ENTER") return (GetAsyncKeyState(VK_RETURN) & 0x8000) != 0;
+#endif
+    return false;
+}
+
 void RunDeviceInputLoop(const DeviceEntry& device)
 {
     restore_original_cout();
     printf("=== Running Device: %s ===\n", device.name.c_str());
     printf("Press ESC (Windows) or HOME (Wii) 5 times to exit.\n\n");
 
+    CalibrateIR();
+
+    // Compile every button up front, pressing a key then only hands the
+    // worker a pointer to frames that are already built.
+    std::vector<const CompiledIR*> compiled(device.buttons.size(), nullptr);
+    for (size_t b = 0; b < device.buttons.size(); b++)
+        compiled[b] = GetCompiledIR(device.buttons[b]);
+
+    if (!IR_WorkerStart())
+        printf("[SendIR] Couldn't start the transmit worker.\n");
+
     int homePressCount = 0;
 
+    // Held state per button, and the button whose command is repeating.
+    std::vector<bool> wasHeld(device.buttons.size(), false);
+    int repeatingButton = -1;
+
     while (true)
     {
 #ifdef NINTENDOWII
         // ---- Wii input ----
         WPAD_ScanPads();
         uint32_t down = WPAD_ButtonsDown(0);
+        uint32_t held = WPAD_ButtonsHeld(0);
         bool homePressed = (down & WPAD_BUTTON_HOME);
 #else
         // ---- Windows native input ----
+        u32 held = 0;
         bool homePressed = (GetAsyncKeyState(VK_ESCAPE) & 0x8000) != 0;
 #endif
 
@@ -644,64 +1388,31 @@ void RunDeviceInputLoop(const DeviceEntry& device)
         }
 
         // ---------------- Regular button mapping ----------------
-        for (const auto& btn : device.buttons)
+        // A press starts the command, it keeps repeating until the key is let go.
+        for (size_t b = 0; b < device.buttons.size(); b++)
         {
+            const ButtonEntry& btn = device.buttons[b];
+            bool isHeld = false;
             for (const auto& map : btn.maps)
+                isHeld = isHeld || MapHeld(map, held);
+
+            // The worker does the logging, nothing here blocks on the console.
+            if (isHeld && !wasHeld[b] && compiled[b])
             {
-#ifdef NINTENDOWII
-                bool pressed = false;
-                // Wii Mappingsx
-                // TODO: Rewrite this
-                if      (map.value == "WPAD_BUTTON_UP") pressed = (down & WPAD_BUTTON_UP) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_DOWN") pressed = (down & WPAD_BUTTON_DOWN) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_LEFT") pressed = (down & WPAD_BUTTON_LEFT) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_RIGHT") pressed = (down & WPAD_BUTTON_RIGHT) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_A") pressed = (down & WPAD_BUTTON_A) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_B") pressed = (down & WPAD_BUTTON_B) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_1") pressed = (down & WPAD_BUTTON_1) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_2") pressed = (down & WPAD_BUTTON_2) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_PLUS") pressed = (down & WPAD_BUTTON_PLUS) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_MINUS") pressed = (down & WPAD_BUTTON_MINUS) ? 1 : 0;
-                if      (map.value == "WPAD_BUTTON_HOME") pressed = (down & WPAD_BUTTON_HOME) ? 1 : 0;
-                if      (map.value == "WPAD_NUNCHUK_C") pressed = (down & WPAD_NUNCHUK_BUTTON_C) ? 1 : 0;
-                if      (map.value == "WPAD_NUNCHUK_Z") pressed = (down & WPAD_NUNCHUK_BUTTON_Z) ? 1 : 0;
-                if      (map.value == "WPAD_CLASSIC_BUTTON_A") pressed = (down & WPAD_CLASSIC_BUTTON_A) ? 1 : 0;
-                if      (map.value == "WPAD_CLASSIC_BUTTON_B") pressed = (down & WPAD_CLASSIC_BUTTON_B) ? 1 : 0;
-                if      (map.value == "WPAD_CLASSIC_BUTTON_X") pressed = (down & WPAD_CLASSIC_BUTTON_X) ? 1 : 0;
-                if      (map.value == "WPAD_CLASSIC_BUTTON_Y") pressed = (down & WPAD_CLASSIC_BUTTON_Y) ? 1 : 0;
-                if      (map.value == "WPAD_CLASSIC_BUTTON_ZL") pressed = (down & WPAD_CLASSIC_BUTTON_ZL) ? 1 : 0;
-                if      (map.value == "WPAD_CLASSIC_BUTTON_ZR") pressed = (down & WPAD_CLASSIC_BUTTON_ZR) ? 1 : 0;
-                if      (map.value == "WPAD_CLASSIC_BUTTON_FULL_L") pressed = (down & WPAD_CLASSIC_BUTTON_FULL_L) ? 1 : 0;
-                if      (map.value == "WPAD_CLASSIC_BUTTON_FULL_R") pressed = (down & WPAD_CLASSIC_BUTTON_FULL_R) ? 1 : 0;
-                if (pressed)
-                {
-                    printf("Button pressed: %s -> Sending IR: %s\n",
-                           btn.name.c_str(), btn.data.c_str());
-                    SendIR(btn.data);
-                }
-#else
-                // Windows key mapping
-                bool pressed = false;
-                if      (map.value == "A") pressed = (GetAsyncKeyState('A') & 0x8000) != 0;
-                else if (map.value == "B") pressed = (GetAsyncKeyState('B') & 0x8000) != 0;
-                else if (map.value == "UP") pressed = (GetAsyncKeyState(VK_UP) & 0x8000) != 0;
-                else if (map.value == "DOWN") pressed = (GetAsyncKeyState(VK_DOWN) & 0x8000) != 0;
-                else if (map.value == "LEFT") pressed = (GetAsyncKeyState(VK_LEFT) & 0x8000) != 0;
-                else if (map.value == "RIGHT") pressed = (GetAsyncKeyState(VK_RIGHT) & 0x8000) != 0;
-                else if (map.value == "1") pressed = (GetAsyncKeyState('1') & 0x8000) != 0;
-                else if (map.value == "2") pressed = (GetAsyncKeyState('2') & 0x8000) != 0;
-                else if (map.value == "+") pressed = (GetAsyncKeyState(VK_OEM_PLUS) & 0x8000) != 0;
-                else if (map.value == "-") pressed = (GetAsyncKeyState(VK_OEM_MINUS) & 0x8000) != 0;
-                else if (map.value == "ENTER") pressed = (GetAsyncKeyState(VK_RETURN) & 0x8000) != 0;
-
-                if (pressed)
-                {
-                    printf("Button pressed: %s -> Sending IR: %s\n",
-                           btn.name.c_str(), btn.data.c_str());
-                    SendIR(btn.data);
-                }
-#endif
+                const CompiledIR *ir = compiled[b];
+                ir_command_t command = { IR_CMD_PRESS, PressFrame(ir),
+                                         ir->hasRepeat ? &ir->repeat : nullptr,
+                                         btn.name.c_str(), ir->raw.get(), ir->macro.get() };
+                if (IR_WorkerEnqueue(&command))
+                    repeatingButton = (int)b;
             }
+            else if (!isHeld && wasHeld[b] && repeatingButton == (int)b)
+            {
+                ir_command_t command = { IR_CMD_RELEASE, nullptr, nullptr, nullptr, nullptr, nullptr };
+                IR_WorkerEnqueue(&command);
+                repeatingButton = -1;
+            }
+            wasHeld[b] = isHeld;
         }
 
 #ifdef NINTENDOWII
@@ -711,6 +1422,15 @@ void RunDeviceInputLoop(const DeviceEntry& device)
 #endif
     }
 
+    // Drain the worker and let the last frame finish before leaving.
+    IR_WorkerStop();
+    ir_worker_stats_t stats;
+    IR_WorkerGetStats(&stats);
+    printf("[SendIR] Worker: %u commands, %u dropped, deepest queue %u, busy %u.%u%%.\n",
+           stats.processed, stats.dropped, stats.max_depth,
+           stats.occupancy_permille / 10, stats.occupancy_permille % 10);
+    IR_TransmitterShutdown();
+
     // Exit when done
     exit(0);
 }
@@ -759,8 +1479,22 @@ void ShowDebuggerWindow(bool* p_open) {
 
     // Checkboxing
     ImGui::Checkbox("Show Metrics", &showMet);
+
+    // Compile traces go to the log
+    static bool verbose = false;
+    if (ImGui::Checkbox("Verbose IR Log", &verbose))
+        SetVerboseIR(verbose);
+
     ImGui::TextLinkOpenURL("Go to the OldNet", "http://theoldnet.com/");
     
+    // Transmit worker
+    ir_worker_stats_t stats;
+    IR_WorkerGetStats(&stats);
+    ImGui::SeparatorText("IR Worker");
+    ImGui::Text("Queue depth: %u (max %u of %u)", stats.depth, stats.max_depth, IR_WORKER_QUEUE_DEPTH);
+    ImGui::Text("Enqueued: %u  Processed: %u  Dropped: %u", stats.enqueued, stats.processed, stats.dropped);
+    ImGui::Text("Occupancy: %u.%u%%", stats.occupancy_permille / 10, stats.occupancy_permille % 10);
+
     // Metrics
     if(showMet) ImGui::ShowMetricsWindow(&showMet);
     ImGui::End();
@@ -980,8 +1714,13 @@ void DrawXMLBrowser(XMLDatabase& db, ImGuiWindowFlags &window_flags)
             ImGui::Separator();
 
             ImGui::Text("Data:");
-            ImGui::InputTextMultiline("##data", (char*)btn.data.c_str(), btn.data.size() + 1,
-                                      ImVec2(-FLT_MIN, 120), ImGuiInputTextFlags_ReadOnly);
+            if (btn.raw)
+                ImGui::TextWrapped("RAW, packed: %u durations (%u repeating), %u distinct, %u bytes.",
+                                   (unsigned)(btn.raw->frame + btn.raw->repeat), (unsigned)btn.raw->repeat,
+                                   (unsigned)btn.raw->sizes, (unsigned)IR_RawDictBytes(btn.raw.get()));
+            else
+                ImGui::InputTextMultiline("##data", (char*)btn.data.c_str(), btn.data.size() + 1,
+                                          ImVec2(-FLT_MIN, 120), ImGuiInputTextFlags_ReadOnly);
         }
         else
         {
@@ -0,0 +1,325 @@
+// irworker.cpp - (C)2025 Dakota Thorpe.
+// Transmit worker, keeps parsing, logging and transmitting off the input thread.
+
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <unistd.h>
+#include <atomic>
+#include "WiiIR/IR.hpp"
+
+#ifndef NINTENDOWII
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#endif
+
+// Bounded single producer / single consumer ring. The producer only ever
+// moves tail and the consumer only ever moves head, so neither side takes a
+// lock: a push or a pop is a couple of loads, a copy and a store.
+template <typename T, u32 N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    bool push(const T &item)
+    {
+        u32 tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == N)
+            return false;
+
+        items_[tail & (N - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item)
+    {
+        u32 head = head_.load(std::memory_order_relaxed);
+        if (tail_.load(std::memory_order_acquire) == head)
+            return false;
+
+        item = items_[head & (N - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    u32 size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    T items_[N];
+    std::atomic<u32> head_{0};
+    std::atomic<u32> tail_{0};
+};
+
+// Command ring and counters.
+static SpscRing<ir_command_t, IR_WORKER_QUEUE_DEPTH> commands;
+static std::atomic<bool> worker_running{false};
+static std::atomic<bool> worker_quit{false};
+static std::atomic<u32> stat_enqueued{0};
+static std::atomic<u32> stat_dropped{0};
+static std::atomic<u32> stat_processed{0};
+static std::atomic<u32> stat_max_depth{0};
+static std::atomic<u32> stat_occupancy{0};
+
+// Frame completion, only ever touched by the worker.
+static ir_tx_handle_t worker_handle;
+
+// Sleeping/waking. The producer rings the doorbell without taking the lock,
+// so a wake-up can race the worker going to sleep. The idle timeout is the
+// backstop for that, a command never waits longer than IR_WORKER_IDLE_US.
+#ifdef NINTENDOWII
+static lwp_t worker_thread = LWP_THREAD_NULL;
+static mutex_t worker_mutex;
+static cond_t worker_cond;
+#else
+static std::thread worker_thread;
+static std::mutex worker_mutex;
+static std::condition_variable worker_cond;
+#endif
+
+static void IR_WorkerWake()
+{
+    #ifdef NINTENDOWII
+    LWP_CondSignal(worker_cond);
+    #else
+    worker_cond.notify_one();
+    #endif
+}
+
+static void IR_WorkerSleep()
+{
+    #ifdef NINTENDOWII
+    // libogc takes the timeout as a relative time.
+    struct timespec timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_nsec = IR_WORKER_IDLE_US * 1000;
+    LWP_MutexLock(worker_mutex);
+    if (commands.size() == 0 && !worker_quit.load())
+        LWP_CondTimedWait(worker_cond, worker_mutex, &timeout);
+    LWP_MutexUnlock(worker_mutex);
+    #else
+    std::unique_lock<std::mutex> lock(worker_mutex);
+    worker_cond.wait_for(lock, std::chrono::microseconds(IR_WORKER_IDLE_US), [] {
+        return commands.size() != 0 || worker_quit.load();
+    });
+    #endif
+}
+
+// Print how closely the last frame kept to its schedule.
+static void PrintTimingReport()
+{
+    ir_timing_report_t report;
+    IR_GetTimingReport(&report);
+    printf("[SendIR] %u edges over %u us, %u late, worst %u ns, mean %d ns, IRQs off for %u us max.\n",
+           report.edges, report.frame_us, report.late_edges,
+           report.worst_error_ns, report.mean_error_ns, report.max_irq_off_us);
+
+    // Running residual for this protocol since the last calibration.
+    ir_residual_t residual;
+    IR_GetResidual(report.protocol, &residual);
+    if (residual.edges)
+        printf("[SendIR] Protocol %u residual: %u frames, mean %d ns, worst %u ns.\n",
+               report.protocol, residual.frames,
+               (int)(residual.total_error_ns / residual.edges), residual.worst_error_ns);
+}
+
+// Hand a command's frame to the transmitter. Packed raw signals go as an
+// edge stream, unpacked a window at a time while they play, macros in one go.
+static bool IR_WorkerSubmit(const ir_command_t &command, const ir_pulse_train_t *repeat, u32 flags)
+{
+    if (command.macro)
+        return IR_TxSubmitMacro(command.macro, flags, &worker_handle);
+    if (!command.raw)
+        return IR_TxSubmit(command.frame, repeat, flags, &worker_handle);
+
+    ir_edge_stream_t stream;
+    IR_StreamInitRaw(&stream, command.raw, false);
+    return IR_TxSubmitStream(&stream, flags, &worker_handle);
+}
+
+// Carry out one command.
+static void IR_WorkerRun(const ir_command_t &command)
+{
+    switch (command.action)
+    {
+        case IR_CMD_SEND:
+            if (!IR_WorkerSubmit(command, nullptr, 0))
+                printf("[SendIR] Transmit queue full, frame dropped.\n");
+            break;
+
+        // A new press takes over straight away: whatever was still pending
+        // for the previous key (queued frames, the next repeat) is cancelled.
+        case IR_CMD_PRESS:
+            if (command.label)
+                printf("[SendIR] Sending %s\n", command.label);
+            if (!IR_WorkerSubmit(command, command.repeat, IR_TX_REPEAT | IR_TX_CANCEL))
+                printf("[SendIR] Transmit queue full, frame dropped.\n");
+            break;
+
+        case IR_CMD_RELEASE:
+            IR_TxStopRepeat();
+            break;
+
+        case IR_CMD_CANCEL:
+            IR_TxCancel();
+            break;
+    }
+}
+
+static void IR_WorkerLoop()
+{
+    u64 started = IR_TimeNow();
+    u64 busy = 0;
+
+    while (!worker_quit.load())
+    {
+        u64 begin = IR_TimeNow();
+
+        ir_command_t command;
+        while (commands.pop(command)) {
+            IR_WorkerRun(command);
+            stat_processed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Report on the last frame once the transmitter is done with it.
+        if (worker_handle.state == IR_TX_DONE) {
+            worker_handle.state = IR_TX_IDLE;
+            PrintTimingReport();
+        } else if (worker_handle.state == IR_TX_CANCELLED) {
+            worker_handle.state = IR_TX_IDLE;
+        }
+
+        u64 end = IR_TimeNow();
+        busy += end - begin;
+        if (end > started)
+            stat_occupancy.store((u32)((busy * 1000) / (end - started)), std::memory_order_relaxed);
+
+        IR_WorkerSleep();
+    }
+}
+
+#ifdef NINTENDOWII
+static void *IR_WorkerEntry(void *arg)
+{
+    (void)arg;
+    IR_WorkerLoop();
+    return NULL;
+}
+#endif
+
+// Start the worker thread (and the transmitter under it).
+bool IR_WorkerStart(void)
+{
+    if (worker_running.load())
+        return true;
+
+    if (!IR_TransmitterInit())
+        return false;
+
+    worker_quit.store(false);
+    worker_handle.state = IR_TX_IDLE;
+
+    #ifdef NINTENDOWII
+    LWP_MutexInit(&worker_mutex, false);
+    LWP_CondInit(&worker_cond);
+    if (LWP_CreateThread(&worker_thread, IR_WorkerEntry, NULL, NULL,
+                         IR_WORKER_STACK_SIZE, IR_WORKER_PRIORITY) < 0) {
+        printf("Error: Couldn't start the IR worker thread.\n");
+        LWP_CondDestroy(worker_cond);
+        LWP_MutexDestroy(worker_mutex);
+        return false;
+    }
+    #else
+    worker_thread = std::thread(IR_WorkerLoop);
+    #endif
+
+    worker_running.store(true);
+    return true;
+}
+
+// Finish whatever is queued and stop the worker.
+void IR_WorkerStop(void)
+{
+    if (!worker_running.load())
+        return;
+
+    // Stop taking commands, then let the worker drain the ring.
+    worker_running.store(false);
+    while (commands.size() != 0) {
+        IR_WorkerWake();
+        usleep(1000);
+    }
+
+    worker_quit.store(true);
+    IR_WorkerWake();
+
+    #ifdef NINTENDOWII
+    LWP_JoinThread(worker_thread, NULL);
+    worker_thread = LWP_THREAD_NULL;
+    LWP_CondDestroy(worker_cond);
+    LWP_MutexDestroy(worker_mutex);
+    #else
+    worker_thread.join();
+    #endif
+}
+
+// Hand a command to the worker. Never blocks, returns false (and counts a
+// drop) if the ring is full or the worker isn't running.
+bool IR_WorkerEnqueue(const ir_command_t *command)
+{
+    if (!worker_running.load(std::memory_order_relaxed) || !commands.push(*command)) {
+        stat_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    stat_enqueued.fetch_add(1, std::memory_order_relaxed);
+
+    // Only the producer raises the high water mark.
+    u32 depth = commands.size();
+    if (depth > stat_max_depth.load(std::memory_order_relaxed))
+        stat_max_depth.store(depth, std::memory_order_relaxed);
+
+    IR_WorkerWake();
+    return true;
+}
+
+void IR_WorkerGetStats(ir_worker_stats_t *stats)
+{
+    stats->depth = commands.size();
+    stats->max_depth = stat_max_depth.load(std::memory_order_relaxed);
+    stats->enqueued = stat_enqueued.load(std::memory_order_relaxed);
+    stats->dropped = stat_dropped.load(std::memory_order_relaxed);
+    stats->processed = stat_processed.load(std::memory_order_relaxed);
+    stats->occupancy_permille = stat_occupancy.load(std::memory_order_relaxed);
+}
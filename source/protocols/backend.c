@@ -0,0 +1,156 @@
+// backend.c - (C)2025 Dakota Thorpe.
+// IR output backends, where the LED edges actually end up.
+
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "WiiIR/IR.hpp"
+
+// ------------------------
+// Sensor bar GPIO
+static void IR_BackendGPIOSet(void *ctx, u32 level)
+{
+    (void)ctx;
+    #ifdef NINTENDOWII
+    _IR_SET_GPIO(IRBLAST_PORT, level ? 255 : 0);
+    #else
+    (void)level;
+    #endif
+}
+
+const ir_backend_t IR_BackendGPIO = {
+    "gpio", IR_BackendGPIOSet, NULL, IR_BACKEND_MODULATED, IR_GPIO_MIN_PULSE_US
+};
+
+// ------------------------
+// Null sink, drops everything. Frames still run at full timing.
+static void IR_BackendNullSet(void *ctx, u32 level)
+{
+    (void)ctx;
+    (void)level;
+}
+
+const ir_backend_t IR_BackendNull = {
+    "null", IR_BackendNullSet, NULL, 0, 0
+};
+
+// ------------------------
+// Edge recorder, stores timestamped level changes in a ring buffer.
+// The buffer is supplied up front so recording never allocates.
+static void IR_BackendRecorderSet(void *ctx, u32 level)
+{
+    ir_edge_recorder_t *recorder = (ir_edge_recorder_t*)ctx;
+    u8 value = level ? 1 : 0;
+    if (recorder->total > 0 && recorder->level == value)
+        return;
+
+    ir_edge_t *edge = &recorder->edges[recorder->head];
+    edge->time = IR_TimeNow();
+    edge->level = value;
+
+    recorder->level = value;
+    recorder->total++;
+    if (++recorder->head == recorder->capacity)
+        recorder->head = 0;
+}
+
+void IR_EdgeRecorderInit(ir_backend_t *backend, ir_edge_recorder_t *recorder, ir_edge_t *buffer, u32 capacity, bool modulated)
+{
+    recorder->edges = buffer;
+    recorder->capacity = capacity;
+    IR_EdgeRecorderClear(recorder);
+
+    backend->name = "recorder";
+    backend->set_level = IR_BackendRecorderSet;
+    backend->ctx = recorder;
+    backend->flags = modulated ? IR_BACKEND_MODULATED : 0;
+    backend->min_pulse_us = 0;
+}
+
+void IR_EdgeRecorderClear(ir_edge_recorder_t *recorder)
+{
+    recorder->head = 0;
+    recorder->total = 0;
+    recorder->level = 0;
+}
+
+// Number of edges still held in the ring.
+u32 IR_EdgeRecorderCount(const ir_edge_recorder_t *recorder)
+{
+    return recorder->total < recorder->capacity ? recorder->total : recorder->capacity;
+}
+
+// Edge by age, 0 is the oldest edge still held.
+const ir_edge_t *IR_EdgeRecorderGet(const ir_edge_recorder_t *recorder, u32 index)
+{
+    u32 count = IR_EdgeRecorderCount(recorder);
+    if (index >= count)
+        return NULL;
+
+    u32 first = (recorder->total < recorder->capacity) ? 0 : recorder->head;
+    return &recorder->edges[(first + index) % recorder->capacity];
+}
+
+// Print the recorded signal as "on off" durations in microseconds,
+// handy for demodulating a frame from a host build.
+void IR_EdgeRecorderDump(const ir_edge_recorder_t *recorder, FILE *out)
+{
+    u32 count = IR_EdgeRecorderCount(recorder);
+    for (u32 i = 1; i < count; i++) {
+        const ir_edge_t *prev = IR_EdgeRecorderGet(recorder, i - 1);
+        const ir_edge_t *edge = IR_EdgeRecorderGet(recorder, i);
+        u64 us = IR_TicksToNanos(edge->time - prev->time) / 1000ULL;
+        fprintf(out, "%s%llu ", prev->level ? "+" : "-", (unsigned long long)us);
+    }
+    fprintf(out, "\n");
+}
+
+// ------------------------
+// Active backend.
+#ifdef NINTENDOWII
+static const ir_backend_t *active_backend = &IR_BackendGPIO;
+#else
+static const ir_backend_t *active_backend = &IR_BackendNull;
+#endif
+
+void IR_SetBackend(const ir_backend_t *backend)
+{
+    #ifdef NINTENDOWII
+    active_backend = backend ? backend : &IR_BackendGPIO;
+    #else
+    active_backend = backend ? backend : &IR_BackendNull;
+    #endif
+}
+
+const ir_backend_t *IR_GetBackend(void)
+{
+    return active_backend;
+}
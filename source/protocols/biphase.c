@@ -0,0 +1,223 @@
+// biphase.c - (C)2025 Dakota Thorpe.
+// Bi-phase (Manchester) encoder, RC5, RC6 and RC6X Protocols.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+// Toggle bit per protocol, flips on every new key press (not on repeats)
+// so the receiver can tell a second press from a held key.
+static bool toggles[IR_PROTO_COUNT];
+
+bool IR_NextToggle(u16 protocol)
+{
+    if (protocol >= IR_PROTO_COUNT)
+        return false;
+
+    bool toggle = toggles[protocol];
+    toggles[protocol] = !toggle;
+    return toggle;
+}
+
+// Bi-phase emitter. A bit is two half-bits of opposite level, so the second
+// half of one bit and the first half of the next are often the same level.
+// Those are merged into one entry as they're written, a frame has about
+// half as many edges as it has half-bits.
+typedef struct {
+    ir_pulse_train_t *train;
+    bool mark;      // Level of the run being built.
+    u32 run;        // Its length so far (us).
+} ir_biphase_t;
+
+// Pick up where the train left off, a trailing mark keeps growing.
+static bool IR_BiphaseBegin(ir_biphase_t *bp, ir_pulse_train_t *train)
+{
+    if (train->count + IR_BIPHASE_MAX_EDGES > train->capacity) {
+        printf("Error: Pulse train overflow (%u entries).\n", (unsigned)train->capacity);
+        return false;
+    }
+
+    bp->train = train;
+    bp->mark = (train->count & 1) != 0;
+    bp->run = bp->mark ? train->durations[--train->count] : 0;
+    return true;
+}
+
+// Write out the run. Leading silence is meaningless, a train starts with a mark.
+static inline void IR_BiphaseFlush(ir_biphase_t *bp)
+{
+    ir_pulse_train_t *train = bp->train;
+    if (bp->run == 0 || (!bp->mark && train->count == 0))
+        return;
+
+    train->durations[train->count++] = bp->run;
+}
+
+static inline void IR_BiphaseHalf(ir_biphase_t *bp, bool mark, u32 duration_us)
+{
+    if (mark != bp->mark) {
+        IR_BiphaseFlush(bp);
+        bp->mark = mark;
+        bp->run = 0;
+    }
+    bp->run += duration_us;
+}
+
+// One bit, 'first' is the level of its first half.
+static inline void IR_BiphaseBit(ir_biphase_t *bp, bool first, u32 half_us)
+{
+    IR_BiphaseHalf(bp, first, half_us);
+    IR_BiphaseHalf(bp, !first, half_us);
+}
+
+// Bits of a field, MSB first (both RC5 and RC6 send MSB first).
+// RC5 sends a 1 as space-mark, RC6 as mark-space.
+static inline void IR_BiphaseField(ir_biphase_t *bp, u32 value, int bits, bool one_mark_first, u32 half_us)
+{
+    for (int bit = bits - 1; bit >= 0; bit--) {
+        bool one = (value >> bit) & 1;
+        IR_BiphaseBit(bp, one == one_mark_first, half_us);
+    }
+}
+
+// Compile an RC5 frame.
+/*
+    DEV Notes:
+        Two start bits, toggle, 5-bit address, 6-bit command, 889uS half-bits.
+        Commands 64-127 are RC5X: the second start bit carries the inverted
+        7th command bit, so the same encoder covers both.
+*/
+bool IR_EncodeRC5(ir_pulse_train_t *train, u8 address, u8 command, bool toggle)
+{
+    ir_biphase_t bp;
+    if (!IR_BiphaseBegin(&bp, train))
+        return false;
+
+    IR_PulseTrainCarrier(train, IR_RC5_CAR_FREQ, 0.33f);
+    train->protocol = IR_PROTO_RC5;
+    train->period_us = IR_RC5_FRAME_PERIOD;
+
+    // Start bits, toggle.
+    IR_BiphaseField(&bp, 1, 1, false, IR_RC5_BURST);
+    IR_BiphaseField(&bp, (command & 0x40) ? 0 : 1, 1, false, IR_RC5_BURST);
+    IR_BiphaseField(&bp, toggle, 1, false, IR_RC5_BURST);
+
+    // Address, command.
+    IR_BiphaseField(&bp, address, 5, false, IR_RC5_BURST);
+    IR_BiphaseField(&bp, command, 6, false, IR_RC5_BURST);
+    IR_BiphaseFlush(&bp);
+    return true;
+}
+
+// RC6 header: leader, start bit, mode and the double width trailer (toggle) bit.
+static void IR_EncodeHeaderRC6(ir_biphase_t *bp, u8 mode, bool toggle)
+{
+    IR_BiphaseHalf(bp, true, IR_RC6_LEADER_PULSE_BURST);
+    IR_BiphaseHalf(bp, false, IR_RC6_LEADER);
+
+    IR_BiphaseField(bp, 1, 1, true, IR_RC6_NORMAL);
+    IR_BiphaseField(bp, mode, 3, true, IR_RC6_NORMAL);
+    IR_BiphaseField(bp, toggle, 1, true, IR_RC6_LEADER);
+}
+
+// Compile an RC6 (mode 0) frame: 8-bit address, 8-bit command.
+bool IR_EncodeRC6(ir_pulse_train_t *train, u8 address, u8 command, bool toggle)
+{
+    ir_biphase_t bp;
+    if (!IR_BiphaseBegin(&bp, train))
+        return false;
+
+    IR_PulseTrainCarrier(train, IR_RC6_CAR_FREQ, 0.33f);
+    train->protocol = IR_PROTO_RC6;
+    train->period_us = IR_RC6_FRAME_PERIOD;
+
+    IR_EncodeHeaderRC6(&bp, IR_RC6_MODE_0, toggle);
+    IR_BiphaseField(&bp, address, 8, true, IR_RC6_NORMAL);
+    IR_BiphaseField(&bp, command, 8, true, IR_RC6_NORMAL);
+    IR_BiphaseFlush(&bp);
+    return true;
+}
+
+// Compile an RC6X (mode 6A, 32-bit) frame: 16-bit address, 16-bit command.
+/*
+    DEV Notes:
+        Like MCE remotes, the trailer bit stays 0 and the toggle is the
+        top bit of the command (0x8000, LIRC's toggle mask for mce). The
+        address goes out as it is, the top bit of an MCE customer code
+        (0x800F) belongs to the code, not the toggle.
+*/
+bool IR_EncodeRC6X(ir_pulse_train_t *train, u16 address, u16 command, bool toggle)
+{
+    ir_biphase_t bp;
+    if (!IR_BiphaseBegin(&bp, train))
+        return false;
+
+    IR_PulseTrainCarrier(train, IR_RC6_CAR_FREQ, 0.33f);
+    train->protocol = IR_PROTO_RC6X;
+    train->period_us = IR_RC6_FRAME_PERIOD;
+
+    command = (command & 0x7FFF) | (toggle ? 0x8000 : 0);
+
+    IR_EncodeHeaderRC6(&bp, IR_RC6_MODE_6, false);
+    IR_BiphaseField(&bp, address, 16, true, IR_RC6_NORMAL);
+    IR_BiphaseField(&bp, command, 16, true, IR_RC6_NORMAL);
+    IR_BiphaseFlush(&bp);
+    return true;
+}
+
+// Senders, each call is a new key press.
+void IR_SendRC5(u8 address, u8 command)
+{
+    u32 buffer[IR_PULSE_TRAIN_MAX];
+    ir_pulse_train_t train;
+    IR_PulseTrainInit(&train, buffer, IR_PULSE_TRAIN_MAX);
+    if (IR_EncodeRC5(&train, address, command, IR_NextToggle(IR_PROTO_RC5)))
+        IR_SendPulseTrain(&train);
+}
+
+void IR_SendRC6(u8 address, u8 command)
+{
+    u32 buffer[IR_PULSE_TRAIN_MAX];
+    ir_pulse_train_t train;
+    IR_PulseTrainInit(&train, buffer, IR_PULSE_TRAIN_MAX);
+    if (IR_EncodeRC6(&train, address, command, IR_NextToggle(IR_PROTO_RC6)))
+        IR_SendPulseTrain(&train);
+}
+
+void IR_SendRC6X(u16 address, u16 command)
+{
+    u32 buffer[IR_PULSE_TRAIN_MAX];
+    ir_pulse_train_t train;
+    IR_PulseTrainInit(&train, buffer, IR_PULSE_TRAIN_MAX);
+    if (IR_EncodeRC6X(&train, address, command, IR_NextToggle(IR_PROTO_RC6X)))
+        IR_SendPulseTrain(&train);
+}
@@ -0,0 +1,132 @@
+// calibrate.c - (C)2025 Dakota Thorpe.
+// Measures the cost of getting an IR edge out and corrects the player for it.
+
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+// Active correction table.
+static ir_calibration_t active_calibration;
+static bool calibrated = false;
+
+// Install a correction table, NULL goes back to uncorrected timing.
+// Residuals are measured against the table in use, so they start over.
+void IR_SetCalibration(const ir_calibration_t *calibration)
+{
+    if (calibration) {
+        active_calibration = *calibration;
+        calibrated = true;
+        IR_SetWaitMargin(calibration->wait_margin_us);
+    } else {
+        calibrated = false;
+        IR_SetWaitMargin(IR_WAIT_SPIN_US);
+    }
+
+    IR_ResetResiduals();
+}
+
+const ir_calibration_t *IR_GetCalibration(void)
+{
+    return calibrated ? &active_calibration : NULL;
+}
+
+// Measure the active backend and wait loops, then install the result.
+// Only ever drives the LED off, so it's safe to run with the sensor bar
+// attached. Takes a few milliseconds, mostly the timed sleeps.
+bool IR_Calibrate(ir_calibration_t *calibration)
+{
+    if (IR_TxBusy()) {
+        printf("Error: Can't calibrate while a frame is being sent.\n");
+        return false;
+    }
+
+    const ir_backend_t *backend = IR_GetBackend();
+    ir_calibration_t result;
+    memset(&result, 0, sizeof(result));
+    result.backend = backend;
+
+    // The short timings are taken with interrupts off, the same way the
+    // player runs its marks.
+    #ifdef NINTENDOWII
+    u32 level = IRQ_Disable();
+    #endif
+
+    // Reading the clock, so it can be taken back out of the spin figure.
+    u64 start = IR_TimeNow();
+    for (u32 i = 0; i < IR_CALIBRATE_SAMPLES; i++)
+        IR_TimeNow();
+    u64 now_ticks = (IR_TimeNow() - start) / IR_CALIBRATE_SAMPLES;
+
+    // One backend call.
+    start = IR_TimeNow();
+    for (u32 i = 0; i < IR_CALIBRATE_SAMPLES; i++)
+        backend->set_level(backend->ctx, 0);
+    result.set_level_ticks = (u32)((IR_TimeNow() - start) / IR_CALIBRATE_SAMPLES);
+
+    // How long a spin wait runs past its deadline. Short waits, the same
+    // length as the ones inside a carrier cycle.
+    u64 step = IR_MicrosToTicks(10);
+    u64 late = 0;
+    for (u32 i = 0; i < IR_CALIBRATE_SAMPLES; i++) {
+        u64 deadline = IR_TimeNow() + step;
+        IR_SpinUntil(deadline);
+        late += IR_TimeNow() - deadline;
+    }
+    late /= IR_CALIBRATE_SAMPLES;
+    result.spin_late_ticks = (u32)((late > now_ticks) ? late - now_ticks : 0);
+
+    #ifdef NINTENDOWII
+    IRQ_Restore(level);
+    #endif
+
+    // Worst oversleep, so IR_WaitUntil wakes up early enough to spin out
+    // the rest of a long space.
+    u64 worst = 0;
+    for (u32 i = 0; i < IR_CALIBRATE_SLEEPS; i++) {
+        start = IR_TimeNow();
+        usleep(IR_CALIBRATE_SLEEP_US);
+        u64 slept_us = IR_TicksToNanos(IR_TimeNow() - start) / 1000ULL;
+        if (slept_us > IR_CALIBRATE_SLEEP_US && slept_us - IR_CALIBRATE_SLEEP_US > worst)
+            worst = slept_us - IR_CALIBRATE_SLEEP_US;
+    }
+    result.sleep_late_us = (u32)worst;
+    result.wait_margin_us = (u32)worst + IR_CALIBRATE_SLACK_US;
+
+    result.lead_ticks = result.set_level_ticks + result.spin_late_ticks;
+
+    IR_SetCalibration(&result);
+    if (calibration)
+        *calibration = result;
+    return true;
+}
@@ -0,0 +1,115 @@
+// carrier.c - (C)2025 Dakota Thorpe.
+// Carrier generator, toggles the IR LED against the timebase instead of usleep.
+
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "WiiIR/IR.hpp"
+
+// Carrier timing cache.
+static ir_carrier_t carrier_cache[IR_CARRIER_CACHE_SIZE];
+static u32 carrier_cache_used = 0;
+static u32 carrier_cache_next = 0;
+
+// Fetch the carrier timing for a frequency/duty pair, working it out in
+// whole timebase ticks the first time it's asked for. Integer math only.
+const ir_carrier_t *IR_CarrierLookup(u32 frequency_hz, u16 duty_permille)
+{
+    for (u32 i = 0; i < carrier_cache_used; i++) {
+        const ir_carrier_t *entry = &carrier_cache[i];
+        if (entry->frequency_hz == frequency_hz && entry->duty_permille == duty_permille)
+            return entry;
+    }
+
+    // Not cached yet, fill a free slot or recycle the oldest one.
+    ir_carrier_t *entry;
+    if (carrier_cache_used < IR_CARRIER_CACHE_SIZE) {
+        entry = &carrier_cache[carrier_cache_used++];
+    } else {
+        entry = &carrier_cache[carrier_cache_next];
+        carrier_cache_next = (carrier_cache_next + 1) % IR_CARRIER_CACHE_SIZE;
+    }
+
+    entry->frequency_hz = frequency_hz;
+    entry->duty_permille = duty_permille;
+    entry->period_ticks = (u32)(IR_TIMEBASE_HZ / frequency_hz);
+    entry->period_rem = (u32)(IR_TIMEBASE_HZ % frequency_hz);
+    entry->on_ticks = (u32)((IR_TIMEBASE_HZ * duty_permille + (u64)frequency_hz * 500ULL) / ((u64)frequency_hz * 1000ULL));
+    return entry;
+}
+
+// Emit carrier cycles from start until end (both in timebase ticks).
+// Runs with interrupts masked, so it only ever spins on the timebase.
+// The period is split into whole ticks plus a remainder that is carried
+// from cycle to cycle, so cycle k starts exactly at
+// start + floor(k * IR_TIMEBASE_HZ / frequency) and a long burst averages
+// the requested frequency. The last cycle is cut short at the end deadline
+// rather than dropped, so the burst length isn't rounded to whole cycles.
+void IR_CarrierBurst(const ir_carrier_t *carrier, u64 start, u64 end)
+{
+    const ir_backend_t *backend = IR_GetBackend();
+    void (*set_level)(void*, u32) = backend->set_level;
+    void *ctx = backend->ctx;
+
+    // Envelope-only backends just see one long pulse.
+    if (!(backend->flags & IR_BACKEND_MODULATED)) {
+        set_level(ctx, 1);
+        IR_SpinUntil(end);
+        set_level(ctx, 0);
+        return;
+    }
+
+    u32 on_ticks = carrier->on_ticks;
+    u32 period_ticks = carrier->period_ticks;
+    u32 period_rem = carrier->period_rem;
+    u32 frequency_hz = carrier->frequency_hz;
+
+    u64 cycle_start = start;
+    u32 error = 0;
+    while (cycle_start < end)
+    {
+        u64 off_edge = cycle_start + on_ticks;
+        if (off_edge > end)
+            off_edge = end;
+
+        set_level(ctx, 1);  // IR LED ON
+        IR_SpinUntil(off_edge);
+        set_level(ctx, 0);  // IR LED OFF
+
+        cycle_start += period_ticks;
+        error += period_rem;
+        if (error >= frequency_hz) {
+            error -= frequency_hz;
+            cycle_start++;
+        }
+        IR_SpinUntil(cycle_start < end ? cycle_start : end);
+    }
+}
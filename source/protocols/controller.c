@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <math.h>
 #include "WiiIR/IR.hpp"
@@ -50,33 +51,361 @@ void _IR_SET_GPIO(u32 gpio, u32 value)
     #endif
 }
 
-// Transmit a specified carrier signal with a duty cycle (0.0 - 1.0) for the specified time.
-void IR_Transmit(float carrier_frequency, int duration_us, float duty_cycle)
+// Start a new pulse train on top of a caller provided buffer.
+// The carrier defaults to 38KHz, encoders set their own.
+void IR_PulseTrainInit(ir_pulse_train_t *train, u32 *buffer, u32 capacity)
 {
-    if (duty_cycle < 0.0f || duty_cycle > 1.0f) {
-        printf("Error: Duty cycle must be between 0.0 and 1.0.\n");
+    train->durations = buffer;
+    train->count = 0;
+    train->capacity = capacity;
+    train->protocol = IR_PROTO_RAW;
+    train->period_us = 0;
+    IR_PulseTrainCarrier(train, 38.0f, 0.33f);
+}
+
+// Set the carrier frequency (KHz) and duty cycle (0.0 - 1.0) of a train.
+void IR_PulseTrainCarrier(ir_pulse_train_t *train, float carrier_frequency, float duty_cycle)
+{
+    train->carrier_hz = (u32)lroundf(carrier_frequency * 1000.0f);
+    train->duty_permille = (u16)lroundf(duty_cycle * 1000.0f);
+}
+
+// Append a duration at the given level (mark = even index, space = odd index).
+// Two segments of the same level in a row are folded into one.
+static bool IR_PulseTrainAppend(ir_pulse_train_t *train, bool mark, u32 duration_us)
+{
+    // A train always starts with a mark, leading silence is meaningless.
+    if (train->count == 0 && !mark)
+        return true;
+
+    if (train->count > 0) {
+        bool last_mark = ((train->count - 1) & 1) == 0;
+        if (last_mark == mark) {
+            train->durations[train->count - 1] += duration_us;
+            return true;
+        }
+    }
+
+    if (train->count >= train->capacity) {
+        printf("Error: Pulse train overflow (%u entries).\n", (unsigned)train->capacity);
+        return false;
+    }
+
+    train->durations[train->count++] = duration_us;
+    return true;
+}
+
+bool IR_PulseTrainMark(ir_pulse_train_t *train, u32 duration_us)
+{
+    return IR_PulseTrainAppend(train, true, duration_us);
+}
+
+bool IR_PulseTrainSpace(ir_pulse_train_t *train, u32 duration_us)
+{
+    return IR_PulseTrainAppend(train, false, duration_us);
+}
+
+// Timing of the last played frame.
+static ir_timing_report_t last_report;
+
+// Calibration residuals per protocol.
+static ir_residual_t residuals[IR_PROTO_COUNT];
+
+// How interrupts are handled during a frame.
+static IRMode_IRQ irq_mode = IR_IRQ_MASK_MARKS;
+
+void IR_GetTimingReport(ir_timing_report_t *report)
+{
+    *report = last_report;
+}
+
+void IR_GetResidual(u16 protocol, ir_residual_t *residual)
+{
+    if (protocol >= IR_PROTO_COUNT) {
+        memset(residual, 0, sizeof(*residual));
         return;
     }
+    *residual = residuals[protocol];
+}
+
+void IR_ResetResiduals(void)
+{
+    memset(residuals, 0, sizeof(residuals));
+}
+
+void IR_SetIrqMode(IRMode_IRQ mode)
+{
+    irq_mode = mode;
+}
+
+// Mask interrupts, keeping track of how long they stay off.
+static inline void IR_PlayerMask(ir_player_t *player)
+{
+    if (player->masked)
+        return;
+
+    #ifdef NINTENDOWII
+    player->irq_level = IRQ_Disable();
+    #endif
+    player->masked = true;
+    player->mask_start = IR_TimeNow();
+}
+
+static inline void IR_PlayerUnmask(ir_player_t *player)
+{
+    if (!player->masked)
+        return;
+
+    u64 off = IR_TimeNow() - player->mask_start;
+    if (off > player->max_irq_off)
+        player->max_irq_off = off;
+
+    player->masked = false;
+    #ifdef NINTENDOWII
+    IRQ_Restore(player->irq_level);
+    #endif
+}
+
+// Get ready to play a frame starting at the given time.
+bool IR_PlayerStart(ir_player_t *player, const ir_pulse_train_t *train, u64 start)
+{
+    if (train->duty_permille > 1000) {
+        printf("Error: Duty cycle must be between 0.0 and 1.0.\n");
+        return false;
+    }
+    if (train->carrier_hz == 0) {
+        printf("Error: Carrier frequency must be above 0.\n");
+        return false;
+    }
+
+    memset(player, 0, sizeof(*player));
+    player->train = train;
+    player->frame_start = start;
+    player->resume_at = start;
+    player->yield = (irq_mode == IR_IRQ_MASK_MARKS);
+
+    // Corrections only hold for the backend they were measured on.
+    const ir_calibration_t *calibration = IR_GetCalibration();
+    if (calibration && calibration->backend == IR_GetBackend()) {
+        player->lead = calibration->lead_ticks;
+        player->edge_cost = calibration->set_level_ticks;
+    }
+
+    // Carrier timing in timebase ticks, straight from the cache.
+    player->carrier = IR_CarrierLookup(train->carrier_hz, train->duty_permille);
+    return true;
+}
 
-    // Calculate the period of one cycle in microseconds.
-    float period_us = (1000.0f / carrier_frequency); // Period in microseconds (1 second / frequency).
-    int cycles = duration_us / period_us;               // Total number of cycles to generate.
+// Get ready to play a stream, it's rewound and generated as it plays.
+bool IR_PlayerStartStream(ir_player_t *player, ir_edge_stream_t *stream, u64 start)
+{
+    if (!IR_StreamRewind(stream))
+        return false;
+    if (!IR_PlayerStart(player, &stream->train, start))
+        return false;
+
+    player->stream = stream;
+    return true;
+}
 
-    // Calculate the on and off times based on the duty cycle.
-    float on_time = floor(period_us * duty_cycle);              // On time based on duty cycle.
-    float off_time = floor(period_us - on_time);                // Off time is the remaining period.
+// Whether the first edge of the frame is out.
+bool IR_PlayerStarted(const ir_player_t *player)
+{
+    return player->index != 0 || player->played != 0;
+}
+
+// Move a stream on to its next window, false if there's nothing left
+// (or the player isn't playing a stream).
+static inline bool IR_PlayerRefill(ir_player_t *player)
+{
+    ir_edge_stream_t *stream = player->stream;
+    if (!stream)
+        return false;
+
+    // Nothing more was generated, the frame ends in the window just played.
+    u32 count = stream->train.count;
+    if (!IR_StreamFill(stream)) {
+        stream->train.count = count;
+        return false;
+    }
+
+    player->played += count;
+    return true;
+}
 
-    // Loop through each cycle
-    for (int i = 0; i < cycles; i++)
+// When IR_PlayerRun should be called next. Interrupts are masked again a
+// little ahead of the next mark so a late interrupt can't push the edge.
+u64 IR_PlayerWakeTime(const ir_player_t *player)
+{
+    if (player->index >= player->train->count)
+        return player->resume_at;
+
+    u64 guard = IR_MicrosToTicks(IR_IRQ_GUARD_US) + player->lead;
+    return (player->resume_at > guard) ? player->resume_at - guard : 0;
+}
+
+// Play the frame until its last edge is out (returns true) or a long space
+// is reached (returns false, with interrupts enabled again). A trailing space
+// and the rest of the frame period aren't waited out here, see
+// IR_PlayerNextStart().
+//
+// Every mark/space edge is pinned to an absolute deadline measured from the
+// start of the frame. A late edge doesn't push the rest of the frame back,
+// the following segment simply comes out shorter and the frame catches up.
+// Each wait ends player->lead early to cover the calibrated overhead of
+// getting the edge out, so the LED switches on the deadline itself.
+bool IR_PlayerRun(ir_player_t *player)
+{
+    const ir_pulse_train_t *train = player->train;
+    const u32 *durations = train->durations;
+    u32 count = train->count;
+    u64 frame_start = player->frame_start;
+    u64 lead = player->lead;
+
+    // Nothing left to play.
+    if (player->index >= count)
+        return true;
+
+    IR_PlayerMask(player);
+    IR_SpinUntil(player->resume_at - lead);
+
+    for (u32 i = player->index; i < count; i++)
     {
-        #ifdef NINTENDOWII
-        _IR_SET_GPIO(0x100, 255);  // IR LED ON
-        usleep((int)on_time);      // Wait for the calculated on-time.
-
-        _IR_SET_GPIO(0x100, 0);    // IR LED OFF
-        usleep((int)off_time);     // Wait for the calculated off-time.
-        #else
-        printf("%d %d ", (int)on_time, (int)off_time);
-        #endif
+        u32 duration = durations[i];
+        u64 edge = frame_start + IR_MicrosToTicks(player->elapsed_us);
+        player->elapsed_us += duration;
+        u64 deadline = frame_start + IR_MicrosToTicks(player->elapsed_us);
+
+        // How far off schedule this edge landed. A space edge has already
+        // gone out at the end of the burst, a mark edge is still a backend
+        // call away.
+        u64 landed = IR_TimeNow();
+        if (!(i & 1))
+            landed += player->edge_cost;
+        s64 error = (s64)(landed - edge);
+        u64 magnitude = (error < 0) ? (u64)-error : (u64)error;
+        player->total_error += error;
+        if (magnitude > player->worst_error)
+            player->worst_error = magnitude;
+        if (error > 0)
+            player->late_edges++;
+
+        // Marks run the carrier right up to the edge deadline.
+        if (!(i & 1)) {
+            IR_CarrierBurst(player->carrier, edge - lead, deadline - lead);
+            continue;
+        }
+
+        // The last space of a stream window. The next window is generated
+        // now, while the LED is off anyway, rather than before the next mark.
+        if (i == count - 1 && IR_PlayerRefill(player)) {
+            count = train->count;
+            i = (u32)-1;
+        }
+
+        // The LED is already off, a trailing space only pushes the next frame back.
+        else if (i == count - 1)
+            break;
+
+        // Long spaces don't need the CPU, let the rest of the system have it.
+        if (player->yield && duration >= IR_IRQ_YIELD_SPACE_US) {
+            IR_PlayerUnmask(player);
+            player->index = i + 1;
+            player->resume_at = deadline;
+            return false;
+        }
+
+        // Short spaces just hold the LED off. Only the marks need interrupts
+        // off, so they're let through until just before the next one.
+        if (player->yield && duration > IR_IRQ_GUARD_US) {
+            IR_PlayerUnmask(player);
+            IR_SpinUntil(deadline - lead - IR_MicrosToTicks(IR_IRQ_GUARD_US));
+            IR_PlayerMask(player);
+        }
+        IR_SpinUntil(deadline - lead);
     }
-}
\ No newline at end of file
+
+    IR_PlayerUnmask(player);
+    player->index = count;
+
+    // The frame slot is the longer of the frame itself and its period.
+    u64 slot_us = player->elapsed_us;
+    if (train->period_us > slot_us)
+        slot_us = train->period_us;
+    player->resume_at = frame_start + IR_MicrosToTicks(slot_us);
+    return true;
+}
+
+// Earliest time the next frame may start, once IR_PlayerRun is done.
+u64 IR_PlayerNextStart(const ir_player_t *player)
+{
+    return player->resume_at;
+}
+
+// Make sure the LED is off and publish the frame timing.
+void IR_PlayerFinish(ir_player_t *player)
+{
+    const ir_backend_t *backend = IR_GetBackend();
+    backend->set_level(backend->ctx, 0);
+    IR_PlayerUnmask(player);
+
+    u32 edges = player->played + player->train->count;
+    s64 total_ns = (player->total_error < 0) ? -(s64)IR_TicksToNanos((u64)-player->total_error)
+                                             : (s64)IR_TicksToNanos((u64)player->total_error);
+    u32 worst_ns = (u32)IR_TicksToNanos(player->worst_error);
+
+    last_report.edges = edges;
+    last_report.late_edges = player->late_edges;
+    last_report.worst_error_ns = worst_ns;
+    last_report.mean_error_ns = edges ? (s32)(total_ns / (s64)edges) : 0;
+    last_report.frame_us = (u32)player->elapsed_us;
+    last_report.max_irq_off_us = (u32)(IR_TicksToNanos(player->max_irq_off) / 1000ULL);
+    last_report.protocol = player->train->protocol;
+
+    if (player->train->protocol < IR_PROTO_COUNT) {
+        ir_residual_t *residual = &residuals[player->train->protocol];
+        residual->frames++;
+        residual->edges += edges;
+        residual->late_edges += player->late_edges;
+        residual->total_error_ns += total_ns;
+        if (worst_ns > residual->worst_error_ns)
+            residual->worst_error_ns = worst_ns;
+    }
+}
+
+// Play back a compiled pulse train, blocking until it's done.
+// All the carrier math is done once up front, the loop only toggles the LED
+// against the timebase, so the encoding cost never lands inside the timed
+// section.
+void IR_PlayPulseTrain(const ir_pulse_train_t *train)
+{
+    // Start one lead out so the first edge can go early too.
+    const ir_calibration_t *calibration = IR_GetCalibration();
+    u64 start = IR_TimeNow() + (calibration ? calibration->lead_ticks : 0);
+
+    ir_player_t player;
+    if (!IR_PlayerStart(&player, train, start))
+        return;
+
+    while (!IR_PlayerRun(&player))
+        IR_WaitUntil(IR_PlayerWakeTime(&player));
+
+    IR_PlayerFinish(&player);
+
+    // Back to back blocking sends still keep to the protocol spacing.
+    IR_WaitUntil(IR_PlayerNextStart(&player));
+}
+
+// Transmit a specified carrier signal with a duty cycle (0.0 - 1.0) for the specified time.
+void IR_Transmit(float carrier_frequency, int duration_us, float duty_cycle)
+{
+    if (duration_us <= 0)
+        return;
+
+    u32 buffer[1];
+    ir_pulse_train_t train;
+    IR_PulseTrainInit(&train, buffer, 1);
+    IR_PulseTrainCarrier(&train, carrier_frequency, duty_cycle);
+    IR_PulseTrainMark(&train, (u32)duration_us);
+    IR_PlayPulseTrain(&train);
+}
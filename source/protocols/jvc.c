@@ -34,45 +34,12 @@
 #include <unistd.h>
 #include "WiiIR/IR.hpp"
 
-// Send 1 bit using JVC pulse-distance encoding
-static inline void IR_SendBit_JVC(bool bit)
-{
-    // Emit burst
-    IR_Transmit(IR_JVC_CAR_FREQ, IR_JVC_BURST, 0.33f);
-
-    // Space depends on the bit
-    if (bit)
-        usleep(IR_JVC_LOGICAL_1 - IR_JVC_BURST);
-    else
-        usleep(IR_JVC_LOGICAL_0 - IR_JVC_BURST);
-}
-
-// Send a byte LSB-first
-static void IR_SendByte_JVC(uint8_t b)
-{
-    for (int i = 0; i < 8; i++)
-        IR_SendBit_JVC((b >> i) & 1);
-}
-
 // Main JVC function
 void IR_SendJVC(uint8_t address, uint8_t command)
 {
-    #ifdef NINTENDOWII
-    uint32_t irq = IRQ_Disable();
-    #endif
-
-    // Header
-    IR_Transmit(IR_JVC_CAR_FREQ, IR_JVC_BGN_SPACE, 0.33f);
-    usleep(IR_JVC_BGN_BREAK);
-
-    // Send 32-bit payload: address, ~address, command, ~command
-    IR_SendByte_JVC(address);
-    IR_SendByte_JVC(command);
-    
-    // Stop bit
-    //IR_Transmit(IR_JVC_CAR_FREQ, IR_JVC_STOP, 0.33f);
-
-    #ifdef NINTENDOWII
-    IRQ_Restore(irq);
-    #endif
-}
\ No newline at end of file
+    u32 buffer[IR_PULSE_TRAIN_MAX];
+    ir_pulse_train_t train;
+    IR_PulseTrainInit(&train, buffer, IR_PULSE_TRAIN_MAX);
+    IR_EncodeJVC(&train, address, command);
+    IR_SendPulseTrain(&train);
+}
@@ -0,0 +1,81 @@
+// kaseikyo.c - (C)2025 Dakota Thorpe.
+// Kaseikyo (Panasonic and friends) Protocol.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+// Kaseikyo timing, in units of IR_KASEIKYO_UNIT.
+static const ir_bit_timing_t kaseikyo_timing = {
+    8 * IR_KASEIKYO_UNIT, 4 * IR_KASEIKYO_UNIT, // Header.
+    IR_KASEIKYO_UNIT, IR_KASEIKYO_UNIT,         // 0.
+    IR_KASEIKYO_UNIT, 3 * IR_KASEIKYO_UNIT,     // 1.
+    IR_KASEIKYO_UNIT,                           // Trailer.
+    0
+};
+
+// Compile a Kaseikyo frame.
+/*
+    DEV Notes:
+        48 bits, LSB first:
+            16-bit vendor ID (0x2002 is Panasonic).
+            4-bit vendor parity, the nibbles of the vendor ID XORed together.
+            12-bit address (4-bit genre1, 4-bit genre2, 4-bit data on Panasonic).
+            8-bit command.
+            8-bit parity, the three bytes before it XORed together.
+        Both parities are worked out here, before the frame starts playing.
+*/
+bool IR_EncodeKaseikyo(ir_edge_stream_t *stream, u16 vendor, u16 address, u8 command)
+{
+    u8 vendor_parity = (vendor ^ (vendor >> 8)) & 0xFF;
+    vendor_parity = (vendor_parity ^ (vendor_parity >> 4)) & 0x0F;
+
+    u8 frame[6];
+    frame[0] = vendor & 0xFF;
+    frame[1] = (vendor >> 8) & 0xFF;
+    frame[2] = vendor_parity | ((address & 0x0F) << 4);
+    frame[3] = (address >> 4) & 0xFF;
+    frame[4] = command;
+    frame[5] = frame[2] ^ frame[3] ^ frame[4];
+
+    IR_StreamInit(stream, &kaseikyo_timing, IR_PROTO_KASEIKYO, IR_KASEIKYO_FRAME_PERIOD);
+    IR_PulseTrainCarrier(&stream->train, IR_KASEIKYO_CAR_FREQ, 0.33f);
+    return IR_StreamAddSection(stream, frame, sizeof(frame));
+}
+
+// Main Kaseikyo function
+void IR_SendKaseikyo(u16 vendor, u16 address, u8 command)
+{
+    ir_edge_stream_t stream;
+    if (IR_EncodeKaseikyo(&stream, vendor, address, command))
+        IR_SendStream(&stream);
+}
@@ -0,0 +1,215 @@
+// macro.c - (C)2025 Dakota Thorpe.
+// Macros, sequences of frames compiled into one transmit schedule.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+/*
+    DEV Notes:
+        Offsets follow the same rules the transmitter uses to space frames
+        it's handed one at a time: a frame of the same protocol starts one
+        frame period after the last one did (or once it's over, if that's
+        later), a frame of another protocol IR_TX_GAP_US after the last one
+        ends. Compiled up front, the transmitter doesn't have to wait for a
+        caller between frames, so the macro goes out as tight as the
+        protocols allow.
+*/
+
+// The protocol and frame period of a step.
+static void IR_MacroFrameTiming(const ir_macro_step_t *step, u16 *protocol, u32 *period_us)
+{
+    if (step->raw) {
+        *protocol = step->raw->protocol;
+        *period_us = 0;
+    } else {
+        *protocol = step->frame->protocol;
+        *period_us = step->frame->period_us;
+    }
+}
+
+// How long a step takes, with and without its trailing space.
+static void IR_MacroFrameLength(ir_macro_step_t *step)
+{
+    u32 count = step->raw ? step->raw->frame : step->frame->count;
+
+    // Signals without a frame play their repeat sequence, it starts at 0 then too.
+    if (step->raw && count == 0)
+        count = step->raw->repeat;
+
+    u64 length = 0, active = 0;
+    for (u32 i = 0; i < count; i++) {
+        u32 duration = step->raw ? IR_RawDictAt(step->raw, i) : step->frame->durations[i];
+        length += duration;
+        if (i < count - 1 || !(i & 1))
+            active += duration;
+    }
+    step->length_us = (u32)length;
+    step->active_us = (u32)active;
+}
+
+// Earliest start for step after last, by the transmitter's spacing rules.
+static u32 IR_MacroNextStart(const ir_macro_step_t *last, const ir_macro_step_t *step)
+{
+    u16 protocol, last_protocol;
+    u32 period_us, last_period_us;
+    IR_MacroFrameTiming(step, &protocol, &period_us);
+    IR_MacroFrameTiming(last, &last_protocol, &last_period_us);
+
+    u32 end = last->offset_us + last->length_us;
+    if (protocol != last_protocol)
+        return end + IR_TX_GAP_US;
+
+    u32 next_start = last->offset_us + last_period_us;
+    return (next_start > end) ? next_start : end;
+}
+
+void IR_MacroInit(ir_macro_t *macro)
+{
+    macro->count = 0;
+    macro->length_us = 0;
+    macro->serial_us = 0;
+}
+
+// Add a frame (or a packed signal) to the end of the macro, delay_us after
+// the earliest it could go. Neither frame is copied, toggled is the frame
+// with its toggle bit flipped (NULL if the protocol has none), the
+// transmitter picks between the two every time the macro is played.
+bool IR_MacroAdd(ir_macro_t *macro, const ir_pulse_train_t *frame, const ir_pulse_train_t *toggled, const ir_raw_dict_t *raw, u32 device, u32 delay_us)
+{
+    if (macro->count >= IR_MACRO_MAX_STEPS) {
+        printf("Error: Macro too long (%d frames).\n", IR_MACRO_MAX_STEPS);
+        return false;
+    }
+    if (!frame && !raw)
+        return false;
+
+    ir_macro_step_t *step = &macro->steps[macro->count];
+    step->frame = frame;
+    step->toggled = frame ? toggled : NULL;
+    step->raw = raw;
+    step->device = device;
+    step->delay_us = delay_us;
+    IR_MacroFrameLength(step);
+
+    step->offset_us = macro->count ? IR_MacroNextStart(&macro->steps[macro->count - 1], step) : 0;
+    step->offset_us += delay_us;
+
+    macro->length_us = step->offset_us + step->length_us;
+    macro->serial_us = macro->length_us;
+    macro->count++;
+    return true;
+}
+
+// Whether a frame at start would come within IR_TX_GAP_US of the marks of
+// a frame for another device. Their trailing spaces are fair game.
+static bool IR_MacroCollides(const ir_macro_step_t *other, u32 start, u32 active_us)
+{
+    return start < other->offset_us + other->active_us + IR_TX_GAP_US &&
+           other->offset_us < start + active_us + IR_TX_GAP_US;
+}
+
+// Plan the macro again, every frame in order at the earliest start its own
+// device's spacing allows, fitted in around the frames already planned for
+// other devices. A delay holds the frame back from the end of everything
+// before it, as it does in order. Steps are sorted by start after.
+// Returns how much sooner the macro is over than one frame after the other,
+// the plan is left as it was if it isn't.
+u32 IR_MacroInterleave(ir_macro_t *macro)
+{
+    u32 serial_offsets[IR_MACRO_MAX_STEPS];
+    for (u32 i = 0; i < macro->count; i++)
+        serial_offsets[i] = macro->steps[i].offset_us;
+
+    for (u32 i = 0; i < macro->count; i++) {
+        ir_macro_step_t *step = &macro->steps[i];
+
+        // A delay waits for everything before it, then for itself.
+        u32 earliest = 0;
+        for (u32 j = 0; j < i && step->delay_us; j++) {
+            u32 end = macro->steps[j].offset_us + macro->steps[j].length_us;
+            if (end > earliest)
+                earliest = end;
+        }
+        earliest += step->delay_us;
+
+        for (u32 j = 0; j < i; j++) {
+            const ir_macro_step_t *other = &macro->steps[j];
+            if (other->device != step->device)
+                continue;
+            u32 next = IR_MacroNextStart(other, step);
+            if (next > earliest)
+                earliest = next;
+        }
+
+        // Slide past other devices' frames until it fits, it only ever moves later.
+        u32 start = earliest;
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (u32 j = 0; j < i; j++) {
+                const ir_macro_step_t *other = &macro->steps[j];
+                if (other->device != step->device && IR_MacroCollides(other, start, step->active_us)) {
+                    start = other->offset_us + other->active_us + IR_TX_GAP_US;
+                    moved = true;
+                }
+            }
+        }
+        step->offset_us = start;
+    }
+
+    u32 length_us = 0;
+    for (u32 i = 0; i < macro->count; i++) {
+        u32 end = macro->steps[i].offset_us + macro->steps[i].length_us;
+        if (end > length_us)
+            length_us = end;
+    }
+
+    if (length_us >= macro->serial_us) {
+        for (u32 i = 0; i < macro->count; i++)
+            macro->steps[i].offset_us = serial_offsets[i];
+        return 0;
+    }
+
+    // Play order, ties keep their order.
+    for (u32 i = 1; i < macro->count; i++) {
+        ir_macro_step_t step = macro->steps[i];
+        u32 j = i;
+        for (; j > 0 && macro->steps[j - 1].offset_us > step.offset_us; j--)
+            macro->steps[j] = macro->steps[j - 1];
+        macro->steps[j] = step;
+    }
+
+    macro->length_us = length_us;
+    return macro->serial_us - length_us;
+}
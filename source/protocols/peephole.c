@@ -0,0 +1,140 @@
+// peephole.c - (C)2025 Dakota Thorpe.
+// Peephole pass over compiled pulse trains.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+/*
+    DEV Notes:
+        A compiled train is the edge program the player runs, one duration
+        per level change. Encoders already fold same level segments as they
+        append, but raw and Pronto data can still carry zero length entries,
+        spaces shorter than the backend can put out and marks that end part
+        way through a carrier cycle (the player cuts that last cycle short).
+
+        Passes, in order:
+            1. Drop zero length entries and leading silence, folding the
+               segments either side together when they're the same level.
+            2. Fold spaces shorter than the backend's minimum pulse into the
+               marks around them (the trailing space is the frame gap, it
+               stays).
+            3. Move every mark to a whole number of carrier cycles, and at
+               least the backend's minimum pulse. The difference comes off
+               the space after it, so every later edge keeps its deadline.
+               A mark whose space is too short to take the difference (it
+               would drop under the minimum pulse) is left as it is. The
+               last mark has no space after it and only moves the frame end.
+*/
+
+// Append a duration to the compacted train, folding it into the last one if same level.
+static inline void IR_PeepholeEmit(u32 *durations, u32 *out, bool mark, u32 duration)
+{
+    if (*out > 0 && (((*out - 1) & 1) == 0) == mark)
+        durations[*out - 1] += duration;
+    else
+        durations[(*out)++] = duration;
+}
+
+void IR_PulseTrainOptimize(ir_pulse_train_t *train, const ir_backend_t *backend, ir_peephole_report_t *report)
+{
+    u32 *durations = train->durations;
+    u32 min_pulse = backend ? backend->min_pulse_us : 0;
+    ir_peephole_report_t stats = { train->count, 0, 0, 0, 0 };
+
+    // 1. Zero length entries and leading silence. The level of an entry is
+    // its position in the input, the output is compacted in place.
+    u32 out = 0;
+    for (u32 i = 0; i < train->count; i++) {
+        bool mark = (i & 1) == 0;
+        if (durations[i] == 0 || (out == 0 && !mark)) {
+            stats.zeros_dropped++;
+            continue;
+        }
+        IR_PeepholeEmit(durations, &out, mark, durations[i]);
+    }
+    train->count = out;
+
+    // 2. Spaces the backend can't get out, the marks either side become
+    // one. The train alternates by now, so a fold keeps it alternating.
+    if (min_pulse > 0) {
+        out = 0;
+        for (u32 i = 0; i < train->count; i++) {
+            if ((i & 1) && i + 1 < train->count && durations[i] < min_pulse) {
+                durations[out - 1] += durations[i] + durations[i + 1];
+                stats.spaces_folded++;
+                i++;
+                continue;
+            }
+            durations[out++] = durations[i];
+        }
+        train->count = out;
+    }
+
+    // 3. Marks to whole carrier cycles (non-modulated signals have none),
+    // and no shorter than the backend minimum.
+    bool modulated = train->carrier_hz > 0 && train->duty_permille < 1000;
+    for (u32 i = 0; i < train->count; i += 2) {
+        u32 mark = durations[i];
+        u32 clamped = mark;
+
+        if (modulated) {
+            u64 cycles = ((u64)mark * train->carrier_hz + 500000ULL) / 1000000ULL;
+            u64 min_cycles = ((u64)min_pulse * train->carrier_hz + 999999ULL) / 1000000ULL;
+            if (cycles < min_cycles)
+                cycles = min_cycles;
+            if (cycles == 0)
+                cycles = 1;
+            clamped = (u32)((cycles * 1000000ULL + train->carrier_hz / 2) / train->carrier_hz);
+        }
+        if (clamped < min_pulse)
+            clamped = min_pulse;
+        if (clamped == mark)
+            continue;
+
+        // The space after gives (or takes) the difference. If it's too
+        // short to, the mark stays, moving it would move every later edge.
+        if (i + 1 < train->count) {
+            s64 space = (s64)durations[i + 1] - ((s64)clamped - (s64)mark);
+            if (space < (s64)(min_pulse ? min_pulse : 1))
+                continue;
+            durations[i + 1] = (u32)space;
+        }
+        durations[i] = clamped;
+        stats.marks_clamped++;
+    }
+
+    stats.edges_after = train->count;
+    if (report)
+        *report = stats;
+}
@@ -31,6 +31,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <math.h>
 #include "WiiIR/IR.hpp"
 
 /*
@@ -73,47 +74,183 @@ float _pronto_calculate_frequency(uint16_t carrier_code) {
     return 1000.0f / (carrier_code * PRONTO_FREQCALC_FLOAT_VAL);
 }
 
-// Function to send pronto codes.
-void IR_SendPronto(const uint16_t *pronto, size_t length) {
-    // Pronto header is 4 bytes.
+// Carrier code to Hz, rounded. Integer math only.
+static u32 IR_ProntoCarrierHz(u16 carrier_code)
+{
+    u64 period_ps = (u64)carrier_code * PRONTO_UNIT_PICOS;
+    return (u32)((1000000000000ULL + period_ps / 2) / period_ps);
+}
+
+// Duration in carrier periods to microseconds, rounded.
+static inline u32 IR_ProntoMicros(u16 periods, u16 carrier_code)
+{
+    return (u32)(((u64)periods * carrier_code * PRONTO_UNIT_PICOS + 500000ULL) / 1000000ULL);
+}
+
+// Make sure a Pronto signal is raw timing and everything it declares is there.
+static bool IR_ProntoValidate(const uint16_t *pronto, size_t length)
+{
+    // Pronto header is 4 words.
     if (length < 4) {
         fprintf(stderr, "Invalid Pronto signal: too short.\n");
-        return;
+        return false;
+    }
+
+    if (pronto[0] != PRONTO_SIGTYPE_RAWIR_MODULATED && pronto[0] != PRONTO_SIGTYPE_RAWIR_NOTMODULATED) {
+        fprintf(stderr, "Invalid Pronto signal: type 0x%04X isn't raw timing.\n", pronto[0]);
+        return false;
+    }
+
+    if (pronto[1] == 0) {
+        fprintf(stderr, "Invalid Pronto signal: no carrier.\n");
+        return false;
+    }
+
+    size_t pairs = (size_t)pronto[2] + pronto[3];
+    if (pairs == 0 || 4 + 2 * pairs > length) {
+        fprintf(stderr, "Invalid Pronto signal: %u pairs declared, %u words given.\n",
+                (unsigned)pairs, (unsigned)length);
+        return false;
+    }
+
+    for (size_t i = 4; i < 4 + 2 * pairs; i++) {
+        if (pronto[i] == 0) {
+            fprintf(stderr, "Invalid Pronto signal: zero duration at word %u.\n", (unsigned)i);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compile one sequence of on/off pairs.
+static bool IR_ProntoSequence(ir_pulse_train_t *train, const uint16_t *pronto, const uint16_t *words, u32 pairs)
+{
+    train->carrier_hz = IR_ProntoCarrierHz(pronto[1]);
+    train->duty_permille = (pronto[0] == PRONTO_SIGTYPE_RAWIR_NOTMODULATED) ? 1000 : 330;
+    train->protocol = IR_PROTO_PRONTO;
+    train->period_us = 0; // The gap is the trailing space of the sequence.
+
+    for (u32 i = 0; i < 2 * pairs; i += 2) {
+        if (!IR_PulseTrainMark(train, IR_ProntoMicros(words[i], pronto[1])) ||
+            !IR_PulseTrainSpace(train, IR_ProntoMicros(words[i + 1], pronto[1])))
+            return false;
+    }
+    return true;
+}
+
+// Compile a raw Pronto signal, once, into integer microsecond trains.
+// frame gets the starting sequence (or the repeating one if there's no
+// starting sequence), repeat gets the repeating sequence to be sent for as
+// long as the key is held (count stays 0 if there isn't one). repeat may be
+// NULL if it isn't wanted.
+bool IR_CompilePronto(const uint16_t *pronto, size_t length, ir_pulse_train_t *frame, ir_pulse_train_t *repeat)
+{
+    if (!IR_ProntoValidate(pronto, length))
+        return false;
+
+    u32 start_pairs = pronto[2];
+    u32 repeat_pairs = pronto[3];
+    const uint16_t *start = pronto + 4;
+    const uint16_t *again = start + 2 * start_pairs;
+
+    if (start_pairs) {
+        if (!IR_ProntoSequence(frame, pronto, start, start_pairs))
+            return false;
+    } else if (!IR_ProntoSequence(frame, pronto, again, repeat_pairs)) {
+        return false;
     }
 
-    // Extract the values of the pronto header.
-    uint16_t signal_type = pronto[0];
-    uint16_t carrier_code = pronto[1];
-    uint16_t start_pairs = pronto[2];
-    uint16_t repeat_pairs = pronto[3];
-
-    // Determine carrier frequency (in KHz)
-    float frequency = _pronto_calculate_frequency(carrier_code);
-
-    printf("Signal Type: 0x%04X\n", signal_type);
-    printf("Carrier Frequency: %.2f KHz\n", frequency);
-    printf("Starting Pairs: %u\n", start_pairs);
-    printf("Repeating Pairs: %u\n", repeat_pairs);
-    printf("Attemting to transmit, Pronto codes aren't yet fully tested.\n");
-    printf("Don't expect results, even if you have given the proper pronto.\n");
-
-    // Send any start pairs.
-    if (start_pairs > 0) {
-        for (size_t i = 4; i < 4 + 2 * start_pairs; i += 2) {
-            int us_on_time = (int)((pronto[i]/frequency)*1000);
-            int us_off_time = (int)((pronto[i + 1]/frequency)*1000);
-            IR_Transmit(frequency, us_on_time, 0.33f);
-            usleep(us_off_time);
+    if (repeat && repeat_pairs)
+        return IR_ProntoSequence(repeat, pronto, again, repeat_pairs);
+    return true;
+}
+
+// Function to compile a pronto code into a pulse train, a single key press.
+// The train's carrier is taken from the pronto header.
+bool IR_EncodePronto(ir_pulse_train_t *train, const uint16_t *pronto, size_t length) {
+    return IR_CompilePronto(pronto, length, train, NULL);
+}
+
+// Decode a coded Pronto signal (RC5, RC6 or NEC1) into the command it
+// stands for, so it can go through the native encoder. Returns false for
+// raw timing, or a coded signal that doesn't make sense.
+/*
+    DEV Notes:
+        5000 0073 0000 0001 SSSS CCCC - RC5, 5-bit system, 7-bit command (RC5X above 63).
+        6000 0073 0000 0001 SSSS CCCC - RC6 mode 0, 8-bit system, 8-bit command.
+        900A 006C 0000 0001 DDdd CCcc - NEC1, device and command, each followed
+                                        by its complement. A device whose low
+                                        byte isn't the complement is NECext.
+*/
+bool IR_ProntoDecode(const uint16_t *pronto, size_t length, ir_code_t *code)
+{
+    if (length < 6 || pronto[2] != 0 || pronto[3] < 1)
+        return false;
+
+    u16 system = pronto[4];
+    u16 command = pronto[5];
+    code->vendor = 0;
+
+    switch (pronto[0]) {
+        case PRONTO_SIGTYPE_RC5:
+            if (system > 0x1F || command > 0x7F)
+                return false;
+            code->protocol = IR_PROTO_RC5;
+            code->address = system;
+            code->command = command;
+            return true;
+
+        case PRONTO_SIGTYPE_RC6:
+            if (system > 0xFF || command > 0xFF)
+                return false;
+            code->protocol = IR_PROTO_RC6;
+            code->address = system;
+            code->command = command;
+            return true;
+
+        case PRONTO_SIGTYPE_NEC1: {
+            u8 device = system >> 8, subdevice = system & 0xFF;
+            u8 data = command >> 8, inverse = command & 0xFF;
+            if ((data ^ inverse) != 0xFF)
+                return false;
+
+            bool standard = ((device ^ subdevice) == 0xFF);
+            code->protocol = standard ? IR_PROTO_NEC : IR_PROTO_NECext;
+            code->address = standard ? device : (u16)(device | (subdevice << 8));
+            code->command = data;
+            return true;
         }
+
+        default:
+            return false;
     }
+}
 
-    // Send any repeat pairs.
-    if (repeat_pairs > 0) {
-        for (size_t i = 4 + 2 * start_pairs; i < 4 + 2 * (start_pairs + repeat_pairs); i += 2) {
-            int us_on_time = (int)((pronto[i]/frequency)*1000);
-            int us_off_time = (int)((pronto[i + 1]/frequency)*1000);
-            IR_Transmit(frequency, us_on_time, 0.33f);
-            usleep(us_off_time);
+// Function to send pronto codes.
+void IR_SendPronto(const uint16_t *pronto, size_t length) {
+    // Coded signals go through the native encoders.
+    ir_code_t code;
+    if (IR_ProntoDecode(pronto, length, &code)) {
+        switch (code.protocol) {
+            case IR_PROTO_RC5:    IR_SendRC5(code.address, code.command); return;
+            case IR_PROTO_RC6:    IR_SendRC6(code.address, code.command); return;
+            case IR_PROTO_NEC:    IR_SendNEC(code.address, code.command); return;
+            case IR_PROTO_NECext: IR_SendNECext(code.address & 0xFF, code.address >> 8, code.command, code.command, true); return;
         }
     }
-}
\ No newline at end of file
+
+    // Pronto codes can be longer than any fixed protocol frame.
+    u32 capacity = (length > 4) ? (u32)(length - 4) : 1;
+    u32 *buffer = (u32*)malloc(capacity * sizeof(u32));
+    if (!buffer) {
+        fprintf(stderr, "Out of memory compiling Pronto signal.\n");
+        return;
+    }
+
+    ir_pulse_train_t train;
+    IR_PulseTrainInit(&train, buffer, capacity);
+    if (IR_EncodePronto(&train, pronto, length))
+        IR_SendPulseTrain(&train);
+
+    free(buffer);
+}
@@ -0,0 +1,207 @@
+// pulse_distance.cpp - (C)2025 Dakota Thorpe.
+// NEC, NECext, Samsung32, JVC and SIRC, as protocol descriptors.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include "WiiIR/IR.hpp"
+#include "WiiIR/PulseDistance.hpp"
+
+#define IR_CARRIER_HZ(khz) ((u32)((khz) * 1000.0f))
+#define IR_DUTY_THIRD 330
+
+// NEC, 8-bit address and command, each followed by its inverse.
+static constexpr ir_pulse_distance_t IR_PD_NEC = {
+    IR_PROTO_NEC, IR_CARRIER_HZ(IR_NEC_CAR_FREQ), IR_DUTY_THIRD,
+    IR_NEC_BGN_SPACE, IR_NEC_END_SPACE,
+    IR_NEC_BURST, IR_NEC_LOGICAL_0 - IR_NEC_BURST,
+    IR_NEC_BURST, IR_NEC_LOGICAL_1 - IR_NEC_BURST,
+    IR_LSB_FIRST, IR_NEC_BURST, IR_NEC_FULL_FRMT
+};
+
+// NECext, same timing, but 16-bit address and no inverse.
+static constexpr ir_pulse_distance_t IR_PD_NECEXT = {
+    IR_PROTO_NECext, IR_CARRIER_HZ(IR_NEC_CAR_FREQ), IR_DUTY_THIRD,
+    IR_NEC_BGN_SPACE, IR_NEC_END_SPACE,
+    IR_NEC_BURST, IR_NEC_LOGICAL_0 - IR_NEC_BURST,
+    IR_NEC_BURST, IR_NEC_LOGICAL_1 - IR_NEC_BURST,
+    IR_LSB_FIRST, IR_NEC_BURST, IR_NEC_FULL_FRMT
+};
+
+// Repeating signal (a.k.a. Key Held Down), 9mS AGC burst, short space and
+// a quick burst. The rest of the 110mS frame is the period.
+static constexpr ir_pulse_distance_t IR_PD_NEC_REPEAT = {
+    IR_PROTO_NEC, IR_CARRIER_HZ(IR_NEC_CAR_FREQ), IR_DUTY_THIRD,
+    IR_NEC_BGN_SPACE, IR_NEC_LOGICAL_1,
+    0, 0, 0, 0,
+    IR_LSB_FIRST, IR_NEC_BURST, IR_NEC_FULL_FRMT
+};
+
+// Bare NEC bits, no header or trailer.
+static constexpr ir_pulse_distance_t IR_PD_NEC_BITS = {
+    IR_PROTO_NEC, IR_CARRIER_HZ(IR_NEC_CAR_FREQ), IR_DUTY_THIRD,
+    0, 0,
+    IR_NEC_BURST, IR_NEC_LOGICAL_0 - IR_NEC_BURST,
+    IR_NEC_BURST, IR_NEC_LOGICAL_1 - IR_NEC_BURST,
+    IR_LSB_FIRST, 0, IR_NEC_FULL_FRMT
+};
+
+// Samsung32, 4.5mS header, spaces are given directly rather than bit periods.
+static constexpr ir_pulse_distance_t IR_PD_SAMSUNG32 = {
+    IR_PROTO_SAMSUNG32, IR_CARRIER_HZ(IR_SAMSUNG32_CAR_FREQ), IR_DUTY_THIRD,
+    IR_SAMSUNG32_BGN_SPACE, IR_SAMSUNG32_BGN_SPACE,
+    IR_SAMSUNG32_BURST, IR_SAMSUNG32_LOGICAL_0,
+    IR_SAMSUNG32_BURST, IR_SAMSUNG32_LOGICAL_1,
+    IR_LSB_FIRST, IR_SAMSUNG32_STOP, IR_SAMSUNG32_FRAME_PERIOD
+};
+
+// JVC, 8-bit address and command, no inverse.
+static constexpr ir_pulse_distance_t IR_PD_JVC = {
+    IR_PROTO_JVC, IR_CARRIER_HZ(IR_JVC_CAR_FREQ), IR_DUTY_THIRD,
+    IR_JVC_BGN_SPACE, IR_JVC_BGN_BREAK,
+    IR_JVC_BURST, IR_JVC_LOGICAL_0 - IR_JVC_BURST,
+    IR_JVC_BURST, IR_JVC_LOGICAL_1 - IR_JVC_BURST,
+    IR_LSB_FIRST, IR_JVC_STOP, IR_JVC_FRAME_PERIOD
+};
+
+// While a key is held JVC sends the same frame again without its header.
+static constexpr ir_pulse_distance_t IR_PD_JVC_REPEAT = {
+    IR_PROTO_JVC, IR_CARRIER_HZ(IR_JVC_CAR_FREQ), IR_DUTY_THIRD,
+    0, 0,
+    IR_JVC_BURST, IR_JVC_LOGICAL_0 - IR_JVC_BURST,
+    IR_JVC_BURST, IR_JVC_LOGICAL_1 - IR_JVC_BURST,
+    IR_LSB_FIRST, IR_JVC_STOP, IR_JVC_FRAME_PERIOD
+};
+
+// SIRC is pulse-width: the mark carries the bit, the space is fixed.
+// The three modes share timing and only differ in their fields.
+static constexpr ir_pulse_distance_t IR_SircDescriptor(u16 protocol)
+{
+    return {
+        protocol, IR_CARRIER_HZ(IR_SIRC_CAR_FREQ), IR_DUTY_THIRD,
+        IR_SIRC_SPACE, IR_SIRC_BURST,
+        IR_SIRC_BURST, IR_SIRC_BURST,
+        IR_SIRC_LOGICAL_1, IR_SIRC_BURST,
+        IR_LSB_FIRST, 0, IR_SIRC_FRAME_PERIOD
+    };
+}
+
+static constexpr ir_pulse_distance_t IR_PD_SIRC12 = IR_SircDescriptor(IR_PROTO_SIRC12);
+static constexpr ir_pulse_distance_t IR_PD_SIRC15 = IR_SircDescriptor(IR_PROTO_SIRC15);
+static constexpr ir_pulse_distance_t IR_PD_SIRC20 = IR_SircDescriptor(IR_PROTO_SIRC20);
+
+// The encoders, one instance per frame layout.
+using IR_NEC        = IR_PulseDistance<IR_PD_NEC, 8, 8, 8, 8>;
+using IR_NECext     = IR_PulseDistance<IR_PD_NECEXT, 8, 8, 8, 8>;
+using IR_NECRepeat  = IR_PulseDistance<IR_PD_NEC_REPEAT>;
+using IR_NECByte    = IR_PulseDistance<IR_PD_NEC_BITS, 8>;
+using IR_Samsung32  = IR_PulseDistance<IR_PD_SAMSUNG32, 8, 8, 8, 8>;
+using IR_JVC        = IR_PulseDistance<IR_PD_JVC, 8, 8>;
+using IR_JVCRepeat  = IR_PulseDistance<IR_PD_JVC_REPEAT, 8, 8>;
+using IR_SIRC12     = IR_PulseDistance<IR_PD_SIRC12, 7, 5>;
+using IR_SIRC15     = IR_PulseDistance<IR_PD_SIRC15, 7, 8>;
+using IR_SIRC20     = IR_PulseDistance<IR_PD_SIRC20, 7, 5, 8>;
+
+static_assert(IR_NEC::length == 67, "NEC is a header, 32 bits and a stop burst");
+static_assert(IR_SIRC20::length <= IR_PULSE_TRAIN_MAX, "Frames must fit a stack train");
+
+// Repeating signal (a.k.a. Key Held Down).
+void IR_EncodeRepeatNEC(ir_pulse_train_t *train)
+{
+    IR_NECRepeat::Encode(train);
+}
+
+// Encode a byte via NEC encoding, LSB first.
+void IR_EncodeByteNEC(ir_pulse_train_t *train, u8 byte, bool inverse)
+{
+    IR_NECByte::Append(train, inverse ? (u8)~byte : byte);
+}
+
+// IR Command (NECext)
+void IR_EncodeNECext(ir_pulse_train_t *train, u8 adrl, u8 adrm, u8 datal, u8 datam, bool invert_dm)
+{
+    IR_NECext::Encode(train, adrl, adrm, datal, invert_dm ? (u8)~datam : datam);
+}
+
+// IR Command (NEC, Standard)
+void IR_EncodeNEC(ir_pulse_train_t *train, u8 adr, u8 data)
+{
+    IR_NEC::Encode(train, adr, (u8)~adr, data, (u8)~data);
+}
+
+// Compile a Samsung32 frame: address, ~address, command, ~command.
+void IR_EncodeSamsung32(ir_pulse_train_t *train, uint8_t address, uint8_t command)
+{
+    IR_Samsung32::Encode(train, address, (u8)~address, command, (u8)~command);
+}
+
+// Compile a JVC frame: address, command.
+void IR_EncodeJVC(ir_pulse_train_t *train, uint8_t address, uint8_t command)
+{
+    IR_JVC::Encode(train, address, command);
+}
+
+// The frame sent while a JVC key is held, the same bits without the header.
+void IR_EncodeRepeatJVC(ir_pulse_train_t *train, uint8_t address, uint8_t command)
+{
+    IR_JVCRepeat::Encode(train, address, command);
+}
+
+// Compile a command.
+/*
+    DEV Notes:
+        LSB First.
+        SIRC12 - 7bit command, 5bit address.
+        SIRC15 - 7bit command, 8bit address.
+        SIRC20 - 7bit command, 5bit address, 8bit extra.
+
+        @param train Pulse train to compile the frame into.
+        @param mode SIRC Transmission mode (i.e. SIRC12,15,20).
+        @param address Address to send command to. (5 or 8 bits, depending on mode).
+        @param data SIRC data. 2 bytes. split into data[extend], data[command]
+        @return false if the mode is unknown.
+*/
+bool IR_EncodeSIRC(ir_pulse_train_t *train, IRMode_SIRC mode, u8 address, u16 data)
+{
+    // Extract the real data.
+    u8 extended = (data >> 8) & 0xFF; // First byte of data (0xFFNN)
+    u8 command  = data & 0xFF;        // Last byte of data (0xNNFF)
+
+    // The next frame starts 45ms after this one did (period_us).
+    switch (mode) {
+        case IR_SIRC_MODE_12:
+            return IR_SIRC12::Encode(train, command, address);
+        case IR_SIRC_MODE_15:
+            return IR_SIRC15::Encode(train, command, address);
+        case IR_SIRC_MODE_20:
+            return IR_SIRC20::Encode(train, command, address, extended);
+        default:
+            printf("Failed to send SIRC byte.\n");
+            return false;
+    }
+}
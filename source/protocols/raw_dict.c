@@ -0,0 +1,165 @@
+// raw_dict.c - (C)2025 Dakota Thorpe.
+// Packed raw signals, a duration table and an index per duration.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+/*
+    DEV Notes:
+        The text of a Pronto signal takes 5 bytes per duration ("0015 "),
+        the compiled train 4. Packed it's half a byte (8 bits past 16
+        distinct durations) plus the table, which for remote controls is
+        a handful of entries. The player pulls durations out of it a window
+        at a time through an edge stream (IR_StreamInitRaw), so nothing is
+        ever expanded.
+*/
+
+// Index of duration in table, adding it if it's new. -1 if the table is full.
+static int IR_RawDictIndex(u32 *table, u32 *sizes, u32 duration)
+{
+    // Tables are small, a linear search beats anything cleverer.
+    for (u32 i = 0; i < *sizes; i++)
+        if (table[i] == duration)
+            return (int)i;
+
+    if (*sizes >= IR_RAW_DICT_MAX)
+        return -1;
+    table[*sizes] = duration;
+    return (int)(*sizes)++;
+}
+
+// Pack a frame and its repeat sequence (either may be NULL or empty).
+// Returns NULL if there's nothing to pack, it has too many distinct
+// durations or there's no memory.
+ir_raw_dict_t *IR_RawDictPack(const ir_pulse_train_t *frame, const ir_pulse_train_t *repeat)
+{
+    u32 frame_count = frame ? frame->count : 0;
+    u32 repeat_count = repeat ? repeat->count : 0;
+    u32 total = frame_count + repeat_count;
+    if (total == 0 || frame_count > 0xFFFF || repeat_count > 0xFFFF)
+        return NULL;
+
+    // Index every duration against the table as it's built.
+    u32 table[IR_RAW_DICT_MAX];
+    u32 sizes = 0;
+    u8 *indices = (u8*)malloc(total);
+    if (!indices)
+        return NULL;
+
+    for (u32 i = 0; i < total; i++) {
+        u32 duration = (i < frame_count) ? frame->durations[i] : repeat->durations[i - frame_count];
+        int index = IR_RawDictIndex(table, &sizes, duration);
+        if (index < 0) {
+            printf("Error: Raw signal has more than %d distinct durations.\n", IR_RAW_DICT_MAX);
+            free(indices);
+            return NULL;
+        }
+        indices[i] = (u8)index;
+    }
+
+    u8 bits = (sizes <= 16) ? 4 : 8;
+    u32 index_bytes = (bits == 4) ? (total + 1) / 2 : total;
+
+    ir_raw_dict_t *dict = (ir_raw_dict_t*)malloc(sizeof(ir_raw_dict_t) + sizes * sizeof(u32) + index_bytes);
+    if (!dict) {
+        free(indices);
+        return NULL;
+    }
+
+    u32 *dict_table = (u32*)(dict + 1);
+    u8 *dict_indices = (u8*)(dict_table + sizes);
+    memcpy(dict_table, table, sizes * sizeof(u32));
+    if (bits == 4) {
+        memset(dict_indices, 0, index_bytes);
+        for (u32 i = 0; i < total; i++)
+            dict_indices[i >> 1] |= indices[i] << ((i & 1) << 2);
+    } else {
+        memcpy(dict_indices, indices, total);
+    }
+    free(indices);
+
+    const ir_pulse_train_t *source = frame_count ? frame : repeat;
+    dict->carrier_hz = source->carrier_hz;
+    dict->duty_permille = source->duty_permille;
+    dict->protocol = source->protocol;
+    dict->frame = (u16)frame_count;
+    dict->repeat = (u16)repeat_count;
+    dict->sizes = (u16)sizes;
+    dict->bits = bits;
+    dict->table = dict_table;
+    dict->indices = dict_indices;
+    return dict;
+}
+
+void IR_RawDictFree(ir_raw_dict_t *dict)
+{
+    free(dict);
+}
+
+// Memory the packed signal takes.
+u32 IR_RawDictBytes(const ir_raw_dict_t *dict)
+{
+    u32 total = dict->frame + dict->repeat;
+    u32 index_bytes = (dict->bits == 4) ? (total + 1) / 2 : total;
+    return sizeof(ir_raw_dict_t) + dict->sizes * sizeof(u32) + index_bytes;
+}
+
+// Duration at a position of the index stream (the repeat sequence starts at dict->frame).
+u32 IR_RawDictAt(const ir_raw_dict_t *dict, u32 position)
+{
+    u32 index = (dict->bits == 4)
+              ? (dict->indices[position >> 1] >> ((position & 1) << 2)) & 0x0F
+              : dict->indices[position];
+    return dict->table[index];
+}
+
+// Expand the frame (or the repeat sequence) back into a pulse train.
+bool IR_RawDictUnpack(const ir_raw_dict_t *dict, bool repeat, ir_pulse_train_t *train)
+{
+    u32 first = repeat ? dict->frame : 0;
+    u32 count = repeat ? dict->repeat : dict->frame;
+    if (count > train->capacity) {
+        printf("Error: Pulse train overflow (%u entries).\n", (unsigned)train->capacity);
+        return false;
+    }
+
+    for (u32 i = 0; i < count; i++)
+        train->durations[i] = IR_RawDictAt(dict, first + i);
+    train->count = count;
+    train->carrier_hz = dict->carrier_hz;
+    train->duty_permille = dict->duty_permille;
+    train->protocol = dict->protocol;
+    train->period_us = 0;
+    return true;
+}
@@ -34,46 +34,12 @@
 #include <unistd.h>
 #include "WiiIR/IR.hpp"
 
-// Send 1 bit using Samsung32 pulse-distance encoding
-static inline void IR_SendBit_Samsung32(bool bit)
-{
-    // Emit burst
-    IR_Transmit(IR_SAMSUNG32_CAR_FREQ, IR_SAMSUNG32_BURST, 0.33f);
-
-    // Space depends on the bit
-    if (bit)
-        usleep(IR_SAMSUNG32_LOGICAL_1);
-    else
-        usleep(IR_SAMSUNG32_LOGICAL_0);
-}
-
-// Send a byte LSB-first
-static void IR_SendByte_Samsung32(uint8_t b)
-{
-    for (int i = 0; i < 8; i++)
-        IR_SendBit_Samsung32((b >> i) & 1);
-}
-
 // Main Samsung32 function
 void IR_SendSamsung32(uint8_t address, uint8_t command)
 {
-    #ifdef NINTENDOWII
-    uint32_t irq = IRQ_Disable();
-    #endif
-
-    // Header
-    IR_Transmit(IR_SAMSUNG32_CAR_FREQ, IR_SAMSUNG32_BGN_SPACE, 0.33f);
-
-    // Send 32-bit payload: address, ~address, command, ~command
-    IR_SendByte_Samsung32(address);
-    IR_SendByte_Samsung32(~address);
-    IR_SendByte_Samsung32(command);
-    IR_SendByte_Samsung32(~command);
-
-    // Stop bit
-    IR_Transmit(IR_SAMSUNG32_CAR_FREQ, IR_SAMSUNG32_STOP, 0.33f);
-
-    #ifdef NINTENDOWII
-    IRQ_Restore(irq);
-    #endif
-}
\ No newline at end of file
+    u32 buffer[IR_PULSE_TRAIN_MAX];
+    ir_pulse_train_t train;
+    IR_PulseTrainInit(&train, buffer, IR_PULSE_TRAIN_MAX);
+    IR_EncodeSamsung32(&train, address, command);
+    IR_SendPulseTrain(&train);
+}
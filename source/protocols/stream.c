@@ -0,0 +1,218 @@
+// stream.c - (C)2025 Dakota Thorpe.
+// Edge streams, frames generated a window at a time while they play.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+// Where the generator is within a section.
+typedef enum {
+    IR_STREAM_HEADER_MARK = 0,
+    IR_STREAM_HEADER_SPACE,
+    IR_STREAM_BIT_MARK,
+    IR_STREAM_BIT_SPACE,
+    IR_STREAM_TRAILER,
+    IR_STREAM_GAP,
+    IR_STREAM_DONE
+} IRState_Stream;
+
+// Set up an empty stream, sections are added with IR_StreamAddSection.
+// The carrier defaults like a pulse train's, IR_PulseTrainCarrier(&stream->train, ...) changes it.
+void IR_StreamInit(ir_edge_stream_t *stream, const ir_bit_timing_t *timing, u16 protocol, u32 period_us)
+{
+    memset(stream, 0, sizeof(*stream));
+    IR_PulseTrainInit(&stream->train, stream->window, IR_STREAM_WINDOW);
+    stream->train.protocol = protocol;
+    stream->train.period_us = period_us;
+    stream->timing = *timing;
+    stream->stage = IR_STREAM_DONE;
+}
+
+// Set up a stream that plays a packed raw signal, its frame or its repeat
+// sequence. The signal isn't copied, it has to outlive the stream.
+void IR_StreamInitRaw(ir_edge_stream_t *stream, const ir_raw_dict_t *raw, bool repeat)
+{
+    memset(stream, 0, sizeof(*stream));
+    IR_PulseTrainInit(&stream->train, stream->window, IR_STREAM_WINDOW);
+    stream->train.carrier_hz = raw->carrier_hz;
+    stream->train.duty_permille = raw->duty_permille;
+    stream->train.protocol = raw->protocol;
+    stream->train.period_us = 0; // The gap is the trailing space of the sequence.
+    stream->raw = raw;
+    stream->raw_repeat = repeat;
+    stream->stage = IR_STREAM_DONE;
+}
+
+// Add a section of payload bytes, sent LSB first.
+bool IR_StreamAddSection(ir_edge_stream_t *stream, const u8 *bytes, u32 length)
+{
+    u32 used = stream->sections ? stream->section_end[stream->sections - 1] : 0;
+    if (stream->sections >= IR_STREAM_MAX_SECTIONS || used + length > IR_STREAM_MAX_BYTES) {
+        printf("Error: Stream payload too long (%u bytes).\n", (unsigned)(used + length));
+        return false;
+    }
+
+    // Sections are held apart by trailer mark, gap space.
+    if (stream->sections > 0 && (stream->timing.trailer_mark == 0 || stream->timing.gap_space == 0)) {
+        printf("Error: Multi section streams need a trailer and a gap.\n");
+        return false;
+    }
+
+    memcpy(stream->payload + used, bytes, length);
+    stream->section_end[stream->sections++] = (u8)(used + length);
+    return true;
+}
+
+static inline bool IR_StreamBit(const ir_edge_stream_t *stream)
+{
+    return (stream->payload[stream->bit >> 3] >> (stream->bit & 7)) & 1;
+}
+
+// Next duration of the frame, false once it's over.
+// Every section but the last comes out as an even number of durations
+// (header, bits, trailer and gap are all pairs), so a window always starts
+// on a mark.
+static bool IR_StreamNext(ir_edge_stream_t *stream, u32 *duration)
+{
+    const ir_bit_timing_t *timing = &stream->timing;
+
+    // Raw sources are mark, space pairs already.
+    if (stream->raw) {
+        if (stream->bit >= stream->raw_end)
+            return false;
+        *duration = IR_RawDictAt(stream->raw, stream->bit++);
+        return true;
+    }
+
+    while (true) {
+        switch (stream->stage) {
+            case IR_STREAM_HEADER_MARK:
+                if (timing->header_mark == 0) {
+                    stream->stage = IR_STREAM_BIT_MARK;
+                    continue;
+                }
+                stream->stage = IR_STREAM_HEADER_SPACE;
+                *duration = timing->header_mark;
+                return true;
+
+            case IR_STREAM_HEADER_SPACE:
+                stream->stage = IR_STREAM_BIT_MARK;
+                *duration = timing->header_space;
+                return true;
+
+            case IR_STREAM_BIT_MARK:
+                if (stream->bit >= stream->section_end[stream->section] * 8) {
+                    stream->stage = IR_STREAM_TRAILER;
+                    continue;
+                }
+                stream->stage = IR_STREAM_BIT_SPACE;
+                *duration = IR_StreamBit(stream) ? timing->one_mark : timing->zero_mark;
+                return true;
+
+            case IR_STREAM_BIT_SPACE:
+                *duration = IR_StreamBit(stream) ? timing->one_space : timing->zero_space;
+                stream->bit++;
+                stream->stage = IR_STREAM_BIT_MARK;
+                return true;
+
+            case IR_STREAM_TRAILER:
+                stream->stage = IR_STREAM_GAP;
+                if (timing->trailer_mark == 0)
+                    continue;
+                *duration = timing->trailer_mark;
+                return true;
+
+            case IR_STREAM_GAP:
+                if (++stream->section >= stream->sections) {
+                    stream->stage = IR_STREAM_DONE;
+                    continue;
+                }
+                stream->stage = IR_STREAM_HEADER_MARK;
+                *duration = timing->gap_space;
+                return true;
+
+            default:
+                return false;
+        }
+    }
+}
+
+// Generate the next window, false if the frame is over.
+bool IR_StreamFill(ir_edge_stream_t *stream)
+{
+    u32 count = 0;
+    while (count < IR_STREAM_WINDOW && IR_StreamNext(stream, &stream->window[count]))
+        count++;
+
+    stream->train.count = count;
+    return count > 0;
+}
+
+// Back to the start of the frame, with the first window ready.
+// Also re-points the window, so a stream can be copied by value.
+bool IR_StreamRewind(ir_edge_stream_t *stream)
+{
+    stream->train.durations = stream->window;
+    stream->train.capacity = IR_STREAM_WINDOW;
+    stream->section = 0;
+    stream->bit = 0;
+    stream->stage = stream->sections ? IR_STREAM_HEADER_MARK : IR_STREAM_DONE;
+
+    if (stream->raw) {
+        const ir_raw_dict_t *raw = stream->raw;
+        bool repeat = (stream->raw_repeat && raw->repeat) || raw->frame == 0;
+        stream->bit = repeat ? raw->frame : 0;
+        stream->raw_end = repeat ? raw->frame + raw->repeat : raw->frame;
+    }
+    return IR_StreamFill(stream);
+}
+
+// Generate the whole frame into a pulse train, for when it has to be kept.
+bool IR_StreamRender(ir_edge_stream_t *stream, ir_pulse_train_t *train)
+{
+    train->carrier_hz = stream->train.carrier_hz;
+    train->duty_permille = stream->train.duty_permille;
+    train->protocol = stream->train.protocol;
+    train->period_us = stream->train.period_us;
+
+    u32 position = 0;
+    for (bool more = IR_StreamRewind(stream); more; more = IR_StreamFill(stream)) {
+        for (u32 i = 0; i < stream->train.count; i++, position++) {
+            bool ok = (position & 1) ? IR_PulseTrainSpace(train, stream->window[i])
+                                     : IR_PulseTrainMark(train, stream->window[i]);
+            if (!ok)
+                return false;
+        }
+    }
+    return true;
+}
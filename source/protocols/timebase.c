@@ -0,0 +1,138 @@
+// timebase.c - (C)2025 Dakota Thorpe.
+// Monotonic timebase used to pin every IR edge to an absolute deadline.
+
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+// Clock in use, NULL means the system timebase.
+static const ir_clock_t *active_clock = NULL;
+
+// How much of a wait is spun rather than slept, set by the calibration.
+static u32 wait_margin_us = IR_WAIT_SPIN_US;
+
+void IR_SetClock(const ir_clock_t *clock)
+{
+    active_clock = clock;
+}
+
+// System timebase in ticks (IR_TIMEBASE_HZ ticks per second).
+static inline u64 IR_SystemTimeNow(void)
+{
+    #ifdef NINTENDOWII
+    return gettime();
+    #else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ULL + (u64)ts.tv_nsec;
+    #endif
+}
+
+// Current time on the active clock.
+u64 IR_TimeNow(void)
+{
+    if (active_clock)
+        return active_clock->now(active_clock->ctx);
+    return IR_SystemTimeNow();
+}
+
+u64 IR_MicrosToTicks(u64 us)
+{
+    return (us * IR_TIMEBASE_HZ) / 1000000ULL;
+}
+
+u64 IR_TicksToNanos(u64 ticks)
+{
+    return (ticks / IR_TIMEBASE_HZ) * 1000000000ULL
+         + ((ticks % IR_TIMEBASE_HZ) * 1000000000ULL) / IR_TIMEBASE_HZ;
+}
+
+void IR_SetWaitMargin(u32 margin_us)
+{
+    wait_margin_us = margin_us;
+}
+
+// Wait until the active clock reaches the deadline.
+// Long waits sleep most of the way and spin the rest, so the wake-up
+// jitter of usleep never shows up in the edge timing.
+void IR_WaitUntil(u64 deadline)
+{
+    if (active_clock) {
+        active_clock->wait_until(active_clock->ctx, deadline);
+        return;
+    }
+
+    u64 now = IR_SystemTimeNow();
+    if (now >= deadline)
+        return;
+
+    u64 remaining_us = ((deadline - now) * 1000000ULL) / IR_TIMEBASE_HZ;
+    if (remaining_us > wait_margin_us)
+        usleep((useconds_t)(remaining_us - wait_margin_us));
+
+    while (IR_SystemTimeNow() < deadline);
+}
+
+// Busy-wait until the active clock reaches the deadline, never sleeps.
+// Used whenever interrupts are masked or we're running from an alarm.
+void IR_SpinUntil(u64 deadline)
+{
+    if (active_clock) {
+        active_clock->wait_until(active_clock->ctx, deadline);
+        return;
+    }
+
+    while (IR_SystemTimeNow() < deadline);
+}
+
+// Virtual clock, time only moves when somebody waits on it.
+// Lets whole frames be played on the host without any real waiting.
+static u64 IR_VirtualClockNow(void *ctx)
+{
+    return ((ir_virtual_clock_t*)ctx)->ticks;
+}
+
+static void IR_VirtualClockWait(void *ctx, u64 deadline)
+{
+    ir_virtual_clock_t *state = (ir_virtual_clock_t*)ctx;
+    if (deadline > state->ticks)
+        state->ticks = deadline;
+}
+
+void IR_VirtualClockInit(ir_clock_t *clock, ir_virtual_clock_t *state)
+{
+    state->ticks = 0;
+    clock->now = IR_VirtualClockNow;
+    clock->wait_until = IR_VirtualClockWait;
+    clock->ctx = state;
+}
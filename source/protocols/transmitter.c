@@ -0,0 +1,721 @@
+// transmitter.c - (C)2025 Dakota Thorpe.
+// Background transmitter, plays frames from a transmit thread so the caller
+// doesn't have to sit and wait for the whole frame to go out.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Includes.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "WiiIR/IR.hpp"
+
+#ifndef NINTENDOWII
+#include <pthread.h>
+#endif
+
+/*
+    How it works:
+        Submitted frames are copied into a small queue and played one at a
+        time by the pulse train player, in steps. Each step plays the marks
+        and short spaces up to the next long space, then re-arms the alarm
+        for the next mark. The calling thread is only busy for the copy.
+
+        On the Wii the alarm callback doesn't play anything itself, it only
+        wakes a high priority LWP thread that runs the step. Playback stays
+        out of interrupt context, interrupts are only masked around the
+        marks and the thread sleeps through the long spaces, which is when
+        lower priority threads get the CPU back (see IR_TX_PRIORITY).
+
+        Every frame starts at the earliest time it legally can. Back to back
+        frames of the same protocol keep to that protocol's frame period
+        (start to start), a frame of another protocol only has to leave
+        IR_TX_GAP_US after the last one ends. Nothing waits out a trailer,
+        the spacing is just taken into account when the next start is picked.
+
+        While a key is held the frame's slot also keeps the compiled repeat
+        train (the protocol's repeat frame, or the full frame again) and the
+        player is restarted on it once per frame period, all from the
+        transmit thread.
+        Nothing is encoded or copied per repeat.
+
+        A cancel drops everything still queued and stops any repeat. The
+        frame on the wire is never cut short, but one that hasn't put out its
+        first edge yet (a pending repeat, say) is dropped too, so a new press
+        goes out as soon as the protocol allows.
+
+        Edge streams are queued by value (a few hundred bytes, however long
+        the frame) and played from a working copy that is rewound for every
+        repeat, the player generates the next window as it goes.
+
+        A macro is queued as one slot that plays its steps in turn, each
+        at its offset from the start of the first (or straight after the
+        previous one, if that ran late). The macro has its spacing worked
+        out already. Releasing a key doesn't
+        stop a macro, a cancel does (between frames).
+
+        Non-Wii builds don't have alarms, so a timer thread stands in for
+        them. It sleeps until the requested time and calls the same step.
+*/
+
+// A queued frame.
+typedef struct {
+    u32 durations[IR_TX_TRAIN_MAX];
+    u32 repeat_durations[IR_PULSE_TRAIN_MAX];
+    ir_pulse_train_t frame;
+    ir_pulse_train_t repeat;    // Only used if repeat.count is non-zero.
+    ir_edge_stream_t stream;    // Played instead of frame if streaming is set.
+    bool streaming;
+    const ir_macro_t *macro;    // Played instead of either if set, not copied.
+    u64 macro_start;            // When the macro's first frame started.
+    u32 macro_steps;            // Steps to play, a cancel cuts it short.
+    u64 macro_toggled;          // Steps that go out with the toggle bit flipped, a bit each.
+    ir_tx_handle_t *handle;
+    bool repeating;             // Keep going until IR_TxStopRepeat.
+    u32 sent;                   // Frames put out so far (first + repeats).
+} ir_tx_slot_t;
+
+// Queue, tx_slots[tx_head] is the frame in the player once tx_active is set.
+static ir_tx_slot_t tx_slots[IR_TX_QUEUE_DEPTH];
+static u32 tx_head = 0;
+static volatile u32 tx_count = 0;
+static volatile bool tx_active = false;
+static bool tx_in_step = false;
+static bool tx_ready = false;
+static ir_player_t tx_player;
+static ir_edge_stream_t tx_stream; // Working copy of a streaming slot.
+
+// The last frame that went out, for spacing the next one.
+static bool tx_last_valid = false;
+static u16 tx_last_protocol = 0;
+static u64 tx_last_end = 0;         // Frame end (trailing space included).
+static u64 tx_last_next_start = 0;  // Start of the next frame period.
+
+#ifdef NINTENDOWII
+static syswd_t tx_alarm;
+static lwp_t tx_thread = LWP_THREAD_NULL;
+static lwpq_t tx_queue;
+static volatile bool tx_woken = false;
+static volatile bool tx_quit = false;
+#else
+#define IR_TX_HOP_US 1000 // Timer thread re-checks its deadline this often.
+
+static pthread_t tx_thread;
+static pthread_mutex_t tx_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t tx_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tx_wake = PTHREAD_COND_INITIALIZER;
+static u64 tx_wake_at = 0;
+static u32 tx_wake_gen = 0;
+static bool tx_scheduled = false;
+static bool tx_quit = false;
+#endif
+
+static void IR_TxSchedule(u64 when);
+
+// The queue is shared with the transmit thread, on the Wii keeping
+// interrupts off is enough to hold it still (nothing can preempt us).
+static inline u32 IR_TxLock(void)
+{
+    #ifdef NINTENDOWII
+    return IRQ_Disable();
+    #else
+    pthread_mutex_lock(&tx_queue_lock);
+    return 0;
+    #endif
+}
+
+static inline void IR_TxUnlock(u32 level)
+{
+    #ifdef NINTENDOWII
+    IRQ_Restore(level);
+    #else
+    (void)level;
+    pthread_mutex_unlock(&tx_queue_lock);
+    #endif
+}
+
+static inline void IR_TxSetState(ir_tx_handle_t *handle, u32 state)
+{
+    if (handle)
+        handle->state = state;
+}
+
+// Earliest legal start for a frame of the given protocol. Also leaves a
+// little room so the first alarm fires before the first edge.
+static u64 IR_TxStartTime(u16 protocol)
+{
+    u64 start = IR_TimeNow() + IR_MicrosToTicks(IR_TX_LEAD_US);
+    if (!tx_last_valid)
+        return start;
+
+    u64 legal = (protocol == tx_last_protocol)
+              ? tx_last_next_start
+              : tx_last_end + IR_MicrosToTicks(IR_TX_GAP_US);
+    return (legal > start) ? legal : start;
+}
+
+// Drop the slot at the head of the queue.
+static void IR_TxPop(u32 state)
+{
+    IR_TxSetState(tx_slots[tx_head].handle, state);
+    tx_slots[tx_head].handle = NULL;
+    tx_head = (tx_head + 1) % IR_TX_QUEUE_DEPTH;
+    tx_count--;
+    tx_active = false;
+}
+
+// Start the player on the next step of a macro, at its offset from the first.
+// The first keeps its distance from whatever went before the macro, the
+// rest are spaced by the macro (frames can sit in another device's gaps).
+static bool IR_TxStartMacroStep(ir_tx_slot_t *slot)
+{
+    const ir_macro_step_t *step = &slot->macro->steps[slot->sent];
+    u64 start = IR_TimeNow() + IR_MicrosToTicks(IR_TX_LEAD_US);
+
+    if (slot->sent == 0) {
+        start = IR_TxStartTime(step->raw ? step->raw->protocol : step->frame->protocol);
+        slot->macro_start = start;
+    }
+    u64 planned = slot->macro_start + IR_MicrosToTicks(step->offset_us);
+    if (planned > start)
+        start = planned;
+
+    if (step->raw) {
+        IR_StreamInitRaw(&tx_stream, step->raw, false);
+        return IR_PlayerStartStream(&tx_player, &tx_stream, start);
+    }
+
+    bool toggled = (slot->macro_toggled >> slot->sent) & 1;
+    return IR_PlayerStart(&tx_player, toggled ? step->toggled : step->frame, start);
+}
+
+// Start the player on a slot's frame, or on its repeat once the first
+// one is out. Streams start over from their queued copy.
+static bool IR_TxStartSlot(ir_tx_slot_t *slot, bool repeat)
+{
+    if (slot->macro)
+        return IR_TxStartMacroStep(slot);
+
+    if (slot->streaming) {
+        tx_stream = slot->stream;
+        tx_stream.raw_repeat |= repeat; // Raw signals have their own repeat sequence.
+        return IR_PlayerStartStream(&tx_player, &tx_stream, IR_TxStartTime(tx_stream.train.protocol));
+    }
+
+    const ir_pulse_train_t *train = (repeat && slot->repeat.count) ? &slot->repeat : &slot->frame;
+    return IR_PlayerStart(&tx_player, train, IR_TxStartTime(train->protocol));
+}
+
+// Load the next queued frame into the player, if it's free. Queue locked.
+static void IR_TxLoadNext(void)
+{
+    while (!tx_active && tx_count > 0)
+    {
+        ir_tx_slot_t *slot = &tx_slots[tx_head];
+        if (!IR_TxStartSlot(slot, false)) {
+            IR_TxPop(IR_TX_CANCELLED);
+            continue;
+        }
+
+        IR_TxSetState(slot->handle, IR_TX_ACTIVE);
+        tx_active = true;
+        IR_TxSchedule(IR_PlayerWakeTime(&tx_player));
+    }
+}
+
+// Remember where the frame that just finished leaves the next one.
+static void IR_TxFrameDone(void)
+{
+    tx_last_valid = true;
+    tx_last_protocol = tx_player.train->protocol;
+    tx_last_end = tx_player.frame_start + IR_MicrosToTicks(tx_player.elapsed_us);
+    tx_last_next_start = IR_PlayerNextStart(&tx_player);
+}
+
+// Drop the frame in the player if it hasn't started. Queue locked.
+static bool IR_TxAbortPending(bool repeats_only)
+{
+    if (!tx_active || tx_in_step || IR_PlayerStarted(&tx_player))
+        return false;
+
+    ir_tx_slot_t *slot = &tx_slots[tx_head];
+    if (repeats_only && (slot->sent == 0 || slot->macro))
+        return false;
+
+    IR_TxPop((slot->sent && !slot->macro) ? IR_TX_DONE : IR_TX_CANCELLED);
+    return true;
+}
+
+// Play the next step of the active frame.
+static void IR_TxStep(void)
+{
+    u32 level = IR_TxLock();
+    if (!tx_active) {
+        IR_TxUnlock(level);
+        return;
+    }
+
+    // A stale wake-up for a frame that was cancelled, the new one has its own.
+    if (!IR_PlayerStarted(&tx_player) &&
+        IR_TimeNow() + IR_MicrosToTicks(IR_IRQ_GUARD_US) < IR_PlayerWakeTime(&tx_player)) {
+        IR_TxUnlock(level);
+        return;
+    }
+
+    tx_in_step = true;
+    IR_TxUnlock(level);
+
+    // The player masks interrupts itself, the queue lock isn't held here.
+    bool done = IR_PlayerRun(&tx_player);
+
+    level = IR_TxLock();
+    tx_in_step = false;
+    if (!done) {
+        IR_TxSchedule(IR_PlayerWakeTime(&tx_player));
+        IR_TxUnlock(level);
+        return;
+    }
+
+    IR_PlayerFinish(&tx_player);
+    IR_TxFrameDone();
+
+    // Key still held, go again at the start of the next frame period.
+    // Macros go on to their next step.
+    ir_tx_slot_t *slot = &tx_slots[tx_head];
+    slot->sent++;
+    if (slot->repeating || (slot->macro && slot->sent < slot->macro_steps)) {
+        if (IR_TxStartSlot(slot, true)) {
+            IR_TxSchedule(IR_PlayerWakeTime(&tx_player));
+            IR_TxUnlock(level);
+            return;
+        }
+    }
+
+    IR_TxPop(IR_TX_DONE);
+    IR_TxLoadNext();
+    IR_TxUnlock(level);
+}
+
+#ifdef NINTENDOWII
+// ------------------------
+// libogc alarm, wakes the transmit thread.
+static void IR_TxAlarm(syswd_t alarm, void *cb_arg)
+{
+    (void)alarm;
+    (void)cb_arg;
+    tx_woken = true;
+    LWP_ThreadSignal(tx_queue);
+}
+
+// Transmit thread, plays a step every time the alarm goes off.
+static void *IR_TxThread(void *arg)
+{
+    (void)arg;
+
+    while (true)
+    {
+        // Sleeping with interrupts off is fine, the queue turns them back on.
+        u32 level = IRQ_Disable();
+        while (!tx_woken && !tx_quit)
+            LWP_ThreadSleep(tx_queue);
+        bool quit = tx_quit;
+        tx_woken = false;
+        IRQ_Restore(level);
+
+        if (quit)
+            break;
+        IR_TxStep();
+    }
+    return NULL;
+}
+
+// Re-arming replaces whatever the alarm was set to before.
+static void IR_TxSchedule(u64 when)
+{
+    u64 now = IR_TimeNow();
+    u64 ns = (when > now) ? IR_TicksToNanos(when - now) : 0;
+    if (ns < IR_TX_MIN_ALARM_NS)
+        ns = IR_TX_MIN_ALARM_NS;
+
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    SYS_SetAlarm(tx_alarm, &ts, IR_TxAlarm, NULL);
+}
+#else
+// ------------------------
+// Timer thread stand-in.
+static void *IR_TxThread(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&tx_lock);
+    while (true)
+    {
+        while (!tx_scheduled && !tx_quit)
+            pthread_cond_wait(&tx_wake, &tx_lock);
+        if (tx_quit)
+            break;
+
+        u64 when = tx_wake_at;
+        u32 gen = tx_wake_gen;
+        tx_scheduled = false;
+        pthread_mutex_unlock(&tx_lock);
+
+        // Wait in short hops so a reschedule (a cancel, say) is noticed.
+        bool moved = false;
+        while (true) {
+            u64 hop = IR_TimeNow() + IR_MicrosToTicks(IR_TX_HOP_US);
+            IR_WaitUntil(hop < when ? hop : when);
+
+            pthread_mutex_lock(&tx_lock);
+            moved = (gen != tx_wake_gen);
+            pthread_mutex_unlock(&tx_lock);
+            if (moved || IR_TimeNow() >= when)
+                break;
+        }
+
+        if (!moved)
+            IR_TxStep();
+
+        pthread_mutex_lock(&tx_lock);
+    }
+    pthread_mutex_unlock(&tx_lock);
+    return NULL;
+}
+
+static void IR_TxSchedule(u64 when)
+{
+    pthread_mutex_lock(&tx_lock);
+    tx_wake_at = when;
+    tx_wake_gen++;
+    tx_scheduled = true;
+    pthread_cond_signal(&tx_wake);
+    pthread_mutex_unlock(&tx_lock);
+}
+#endif
+
+// Bring up the alarm and transmit thread (or timer thread).
+bool IR_TransmitterInit(void)
+{
+    if (tx_ready)
+        return true;
+
+    #ifdef NINTENDOWII
+    if (SYS_CreateAlarm(&tx_alarm) < 0) {
+        printf("Error: Couldn't create the IR transmit alarm.\n");
+        return false;
+    }
+
+    tx_quit = false;
+    tx_woken = false;
+    LWP_InitQueue(&tx_queue);
+    if (LWP_CreateThread(&tx_thread, IR_TxThread, NULL, NULL,
+                         IR_TX_STACK_SIZE, IR_TX_PRIORITY) < 0) {
+        printf("Error: Couldn't start the IR transmit thread.\n");
+        LWP_CloseQueue(tx_queue);
+        SYS_RemoveAlarm(tx_alarm);
+        tx_thread = LWP_THREAD_NULL;
+        return false;
+    }
+    #else
+    tx_quit = false;
+    if (pthread_create(&tx_thread, NULL, IR_TxThread, NULL) != 0) {
+        printf("Error: Couldn't start the IR transmit thread.\n");
+        return false;
+    }
+    #endif
+
+    tx_ready = true;
+    return true;
+}
+
+// Let the queue drain and tear the engine down.
+void IR_TransmitterShutdown(void)
+{
+    if (!tx_ready)
+        return;
+
+    IR_TxStopRepeat();
+    IR_TxWait(NULL);
+
+    #ifdef NINTENDOWII
+    SYS_RemoveAlarm(tx_alarm);
+
+    u32 level = IRQ_Disable();
+    tx_quit = true;
+    LWP_ThreadSignal(tx_queue);
+    IRQ_Restore(level);
+    LWP_JoinThread(tx_thread, NULL);
+    LWP_CloseQueue(tx_queue);
+    tx_thread = LWP_THREAD_NULL;
+    #else
+    pthread_mutex_lock(&tx_lock);
+    tx_quit = true;
+    pthread_cond_signal(&tx_wake);
+    pthread_mutex_unlock(&tx_lock);
+    pthread_join(tx_thread, NULL);
+    #endif
+
+    tx_ready = false;
+}
+
+// Copy a train into a slot buffer.
+static bool IR_TxCopy(ir_pulse_train_t *dest, u32 *buffer, u32 capacity, const ir_pulse_train_t *train)
+{
+    if (train->count > capacity) {
+        printf("Error: Frame too long for the transmitter (%u entries).\n", (unsigned)train->count);
+        return false;
+    }
+
+    memcpy(buffer, train->durations, train->count * sizeof(u32));
+    *dest = *train;
+    dest->durations = buffer;
+    dest->capacity = capacity;
+    return true;
+}
+
+// Drop everything still queued, stop any repeat and drop the frame in the
+// player if it hasn't started yet. Queue locked.
+static void IR_TxCancelLocked(void)
+{
+    u32 keep = tx_active ? 1 : 0;
+    while (tx_count > keep) {
+        u32 last = (tx_head + tx_count - 1) % IR_TX_QUEUE_DEPTH;
+        IR_TxSetState(tx_slots[last].handle, IR_TX_CANCELLED);
+        tx_slots[last].handle = NULL;
+        tx_count--;
+    }
+
+    if (tx_active) {
+        tx_slots[tx_head].repeating = false;
+        tx_slots[tx_head].macro_steps = tx_slots[tx_head].sent + 1;
+        IR_TxAbortPending(false);
+    }
+}
+
+// Find room for a frame at the back of the queue. Queue locked.
+static ir_tx_slot_t *IR_TxReserve(u32 flags)
+{
+    if (flags & IR_TX_CANCEL)
+        IR_TxCancelLocked();
+
+    if (tx_count >= IR_TX_QUEUE_DEPTH)
+        return NULL;
+
+    return &tx_slots[(tx_head + tx_count) % IR_TX_QUEUE_DEPTH];
+}
+
+// Queue the reserved slot and get it going if the player is free. Queue locked.
+static void IR_TxCommit(ir_tx_slot_t *slot, u32 flags, ir_tx_handle_t *handle)
+{
+    // A handle only ever follows its latest frame.
+    if (handle) {
+        for (u32 i = 0; i < tx_count; i++) {
+            ir_tx_slot_t *other = &tx_slots[(tx_head + i) % IR_TX_QUEUE_DEPTH];
+            if (other->handle == handle)
+                other->handle = NULL;
+        }
+    }
+
+    slot->handle = handle;
+    slot->repeating = (flags & IR_TX_REPEAT) != 0;
+    slot->sent = 0;
+    IR_TxSetState(handle, IR_TX_QUEUED);
+    tx_count++;
+
+    IR_TxLoadNext();
+}
+
+// Queue a frame and return straight away. The trains are copied, the caller
+// can reuse its buffers immediately.
+//
+// flags:
+//     IR_TX_REPEAT  Keep sending repeat (or the frame again, if repeat is
+//                   NULL) once per frame period until IR_TxStopRepeat.
+//     IR_TX_CANCEL  Cancel everything pending first (see IR_TxCancel).
+//
+// Returns false if the queue is full or the frame doesn't fit.
+bool IR_TxSubmit(const ir_pulse_train_t *frame, const ir_pulse_train_t *repeat, u32 flags, ir_tx_handle_t *handle)
+{
+    if (!IR_TransmitterInit())
+        return false;
+
+    u32 level = IR_TxLock();
+
+    ir_tx_slot_t *slot = IR_TxReserve(flags);
+    if (!slot || !IR_TxCopy(&slot->frame, slot->durations, IR_TX_TRAIN_MAX, frame)) {
+        IR_TxUnlock(level);
+        return false;
+    }
+
+    slot->repeat.count = 0;
+    if (repeat && !IR_TxCopy(&slot->repeat, slot->repeat_durations, IR_PULSE_TRAIN_MAX, repeat)) {
+        IR_TxUnlock(level);
+        return false;
+    }
+
+    slot->streaming = false;
+    slot->macro = NULL;
+    IR_TxCommit(slot, flags, handle);
+    IR_TxUnlock(level);
+    return true;
+}
+
+// Queue an edge stream, same flags as IR_TxSubmit (a repeat replays the
+// whole stream, or a raw signal's repeat sequence). The stream is copied,
+// the caller's can go straight away (a packed raw signal it points at can't).
+bool IR_TxSubmitStream(const ir_edge_stream_t *stream, u32 flags, ir_tx_handle_t *handle)
+{
+    if (!IR_TransmitterInit())
+        return false;
+
+    u32 level = IR_TxLock();
+
+    ir_tx_slot_t *slot = IR_TxReserve(flags);
+    if (!slot) {
+        IR_TxUnlock(level);
+        return false;
+    }
+
+    slot->stream = *stream;
+    slot->streaming = true;
+    slot->macro = NULL;
+    slot->repeat.count = 0;
+    IR_TxCommit(slot, flags, handle);
+    IR_TxUnlock(level);
+    return true;
+}
+
+// Queue a macro, played once from start to end (IR_TX_REPEAT doesn't
+// apply, IR_TX_CANCEL does). Nothing is copied, the macro and its frames
+// have to outlive it.
+bool IR_TxSubmitMacro(const ir_macro_t *macro, u32 flags, ir_tx_handle_t *handle)
+{
+    if (macro->count == 0 || !IR_TransmitterInit())
+        return false;
+
+    u32 level = IR_TxLock();
+
+    ir_tx_slot_t *slot = IR_TxReserve(flags);
+    if (!slot) {
+        IR_TxUnlock(level);
+        return false;
+    }
+
+    // Every step is a new key press, protocols with a toggle bit flip it
+    // for each, in the order they go out.
+    slot->macro_toggled = 0;
+    for (u32 i = 0; i < macro->count; i++) {
+        const ir_macro_step_t *step = &macro->steps[i];
+        if (step->toggled && IR_NextToggle(step->frame->protocol))
+            slot->macro_toggled |= 1ULL << i;
+    }
+
+    slot->streaming = false;
+    slot->macro = macro;
+    slot->macro_steps = macro->count;
+    slot->repeat.count = 0;
+    IR_TxCommit(slot, flags & ~IR_TX_REPEAT, handle);
+    IR_TxUnlock(level);
+    return true;
+}
+
+// Fire and forget, used by the streaming IR_Send* helpers.
+void IR_SendStream(const ir_edge_stream_t *stream)
+{
+    if (!IR_TxSubmitStream(stream, 0, NULL))
+        printf("Error: IR transmit queue full, frame dropped.\n");
+}
+
+// Queue a single frame.
+bool IR_PlayPulseTrainAsync(const ir_pulse_train_t *train, ir_tx_handle_t *handle)
+{
+    return IR_TxSubmit(train, NULL, 0, handle);
+}
+
+// Fire and forget, used by the IR_Send* helpers.
+void IR_SendPulseTrain(const ir_pulse_train_t *train)
+{
+    if (!IR_TxSubmit(train, NULL, 0, NULL))
+        printf("Error: IR transmit queue full, frame dropped.\n");
+}
+
+// Queue a frame that repeats until IR_TxStopRepeat.
+bool IR_PlayPulseTrainRepeat(const ir_pulse_train_t *frame, const ir_pulse_train_t *repeat, ir_tx_handle_t *handle)
+{
+    return IR_TxSubmit(frame, repeat, IR_TX_REPEAT, handle);
+}
+
+// Key released, the frame on the wire finishes and no further repeat
+// follows it. The first frame of a press always goes out in full.
+void IR_TxStopRepeat(void)
+{
+    if (!tx_ready)
+        return;
+
+    u32 level = IR_TxLock();
+    for (u32 i = 0; i < tx_count; i++)
+        tx_slots[(tx_head + i) % IR_TX_QUEUE_DEPTH].repeating = false;
+
+    if (IR_TxAbortPending(true))
+        IR_TxLoadNext();
+    IR_TxUnlock(level);
+}
+
+// Drop everything that isn't already on the wire.
+void IR_TxCancel(void)
+{
+    if (!tx_ready)
+        return;
+
+    u32 level = IR_TxLock();
+    IR_TxCancelLocked();
+    IR_TxLoadNext();
+    IR_TxUnlock(level);
+}
+
+bool IR_TxBusy(void)
+{
+    return tx_count > 0;
+}
+
+// Block until the frame behind the handle is done (or cancelled), or until
+// the queue is empty if no handle is given.
+void IR_TxWait(ir_tx_handle_t *handle)
+{
+    if (handle) {
+        while (handle->state == IR_TX_QUEUED || handle->state == IR_TX_ACTIVE)
+            usleep(1000);
+        return;
+    }
+
+    while (tx_count > 0)
+        usleep(1000);
+}
@@ -0,0 +1,229 @@
+// parse_bench.cpp - (C)2025 Dakota Thorpe.
+// Microbenchmark for the <Data> string parser, time and heap allocations per parse.
+
+/*
+ * Copyright 2025 Dakota Thorpe and Larsen Vallecillo
+ *
+ * This file is part of the Wii IR project.
+ *
+ * Permission is hereby granted to view the source code of this project for informational purposes only.
+ *
+ * The following rights are explicitly prohibited for all individuals and entities except Dakota Thorpe 
+ * and Larsen Vallecillo:
+ * - Copying
+ * - Modifying
+ * - Distributing
+ * - Sharing
+ * - Using
+ *
+ * No part of this project may be reproduced, distributed, or transmitted in any form or by any means, 
+ * including but not limited to copying, modification, or incorporation into other projects, without 
+ * prior written permission from Dakota Thorpe and Larsen Vallecillo.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT 
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, OR NON-INFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES, OR OTHER LIABILITY, 
+ * WHETHER IN AN ACTION OF CONTRACT, TORT, OR OTHERWISE, ARISING FROM, OUT OF, OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+    DEV Notes:
+        Runs on the host, not part of the Wii build:
+
+            g++ -std=c++17 -O2 -Iinclude tools/parse_bench.cpp -o parse_bench
+            ./parse_bench
+
+        "stringstream" is the parser SendIR used before DataParse.hpp (one
+        std::string per token, strtol per word), kept here as the baseline.
+        Allocations are counted by replacing the global operator new.
+
+        The ingestion run decodes a database worth of Pronto bodies three
+        ways: one from_chars per token, the scalar bulk decoder Broadway
+        uses, and IR_ParseHexWords with whatever SIMD the host has.
+*/
+
+#include "WiiIR/DataParse.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <chrono>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// ---- Baseline ----
+static std::string trim(const std::string &s)
+{
+    size_t start = s.find_first_not_of(" \t\r\n");
+    size_t end   = s.find_last_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    return s.substr(start, end - start + 1);
+}
+
+static size_t OldParseRaw(const std::string &data)
+{
+    std::stringstream ss(trim(data).substr(4));
+    std::string token;
+    std::vector<uint16_t> pronto;
+    while (ss >> token) {
+        std::string clean;
+        for (char c : token)
+            if (isxdigit(c)) clean += c;
+        if (!clean.empty())
+            pronto.push_back((uint16_t)strtol(clean.c_str(), nullptr, 16));
+    }
+    return pronto.size();
+}
+
+static size_t OldParseCommand(const std::string &dataString)
+{
+    std::string data = trim(dataString);
+    std::string body = data.substr(data.find(':') + 1);
+    size_t commaPos = body.find(',');
+    std::string adrStr = trim(body.substr(0, commaPos));
+    std::string cmdStr = trim(body.substr(commaPos + 1));
+    return (size_t)strtol(adrStr.c_str(), nullptr, 10) + (size_t)strtol(cmdStr.c_str(), nullptr, 10);
+}
+
+// ---- DataParse.hpp ----
+static size_t NewParseRaw(const std::string &data)
+{
+    static uint16_t words[4096];
+    std::string_view prefix, body;
+    if (!IR_SplitCommand(data, prefix, body) || !IR_PrefixIs(prefix, "RAW"))
+        return 0;
+    return (size_t)IR_ParseHexWords(body, words, 4096);
+}
+
+static size_t NewParseCommand(const std::string &data)
+{
+    uint32_t fields[3];
+    std::string_view prefix, body;
+    if (!IR_SplitCommand(data, prefix, body) || IR_ParseFields(body, fields, 3) != 2)
+        return 0;
+    return fields[0] + fields[1];
+}
+
+// from_chars for every token, what IR_ParseHexWords did before the bulk decoder.
+static int PerTokenHexWords(std::string_view body, uint16_t *words, int capacity)
+{
+    int count = 0;
+    size_t pos = 0;
+    while (true) {
+        while (pos < body.size() && (IR_IsBlank(body[pos]) || body[pos] == ','))
+            pos++;
+        if (pos == body.size())
+            return count;
+
+        size_t end = pos;
+        while (end < body.size() && !IR_IsBlank(body[end]) && body[end] != ',')
+            end++;
+        if (count == capacity || !IR_ParseNumber(body.substr(pos, end - pos), words[count], 16))
+            return -1;
+        count++;
+        pos = end;
+    }
+}
+
+static int ScalarHexWords(std::string_view body, uint16_t *words, int capacity)
+{
+    size_t consumed;
+    int count = IR_DecodeHexRunScalar(body.data(), body.size(), words, capacity, consumed);
+    return (consumed == body.size()) ? count : -1;
+}
+
+// Decode every body once per pass, report words per second.
+template <typename Decoder>
+static void Ingest(const char *name, const std::vector<std::string> &bodies, Decoder decode)
+{
+    static uint16_t words[4096];
+    const int passes = 20;
+    size_t total = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < passes; p++)
+        for (const std::string &body : bodies)
+            total += (size_t)decode(body, words, 4096);
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("  %-14s %8.1f M words/s\n", name, total / seconds / 1e6);
+}
+
+// Run a parser over the same string, report per parse.
+template <typename Parser>
+static void Bench(const char *name, const std::string &data, Parser parse)
+{
+    const int iterations = 20000;
+    size_t check = 0;
+
+    size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        check += parse(data);
+    auto end = std::chrono::steady_clock::now();
+    size_t allocated = allocations - before;
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    printf("  %-14s %10.1f ns/parse %8.1f allocations/parse  (%zu)\n",
+           name, ns, (double)allocated / iterations, check / iterations);
+}
+
+int main()
+{
+    // A 200 word Pronto code, the way the database writes them.
+    std::string raw = "RAW:0000 006D 0062 0000";
+    for (int i = 0; i < 98; i++)
+        raw += (i & 1) ? " 0016 0041" : " 0016 0016";
+
+    std::string command = "NEC: 4, 8";
+
+    printf("RAW, 200 words:\n");
+    Bench("stringstream", raw, OldParseRaw);
+    Bench("DataParse", raw, NewParseRaw);
+
+    printf("%s:\n", command.c_str());
+    Bench("stringstream", command, OldParseCommand);
+    Bench("DataParse", command, NewParseCommand);
+
+    // 5000 signals of 40 to 300 words, like a Flipper database.
+    std::vector<std::string> bodies;
+    uint32_t seed = 1;
+    for (int i = 0; i < 5000; i++) {
+        std::string body = "0000 006D 0000 0000";
+        int pairs = 20 + (int)((seed = seed * 1103515245 + 12345) >> 16) % 130;
+        for (int w = 0; w < pairs * 2; w++) {
+            char word[6];
+            snprintf(word, sizeof(word), " %04X", (unsigned)((seed = seed * 1103515245 + 12345) >> 16) & 0x0FFF);
+            body += word;
+        }
+        bodies.push_back(body);
+    }
+
+#if defined(IR_HEX_SSE2)
+    const char *simd = "SSE2";
+#elif defined(IR_HEX_NEON)
+    const char *simd = "NEON";
+#else
+    const char *simd = "no SIMD";
+#endif
+    printf("Pronto ingestion, %zu signals (%s):\n", bodies.size(), simd);
+    Ingest("per token", bodies, PerTokenHexWords);
+    Ingest("bulk scalar", bodies, ScalarHexWords);
+    Ingest("bulk", bodies, IR_ParseHexWords);
+    return 0;
+}